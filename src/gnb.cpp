@@ -16,7 +16,9 @@
 #include <lib/app/base_app.hpp>
 #include <lib/app/cli_base.hpp>
 #include <lib/app/cli_cmd.hpp>
+#include <lib/app/logging.hpp>
 #include <lib/app/proc_table.hpp>
+#include <lib/app/queue_config.hpp>
 #include <utils/constants.hpp>
 #include <utils/io.hpp>
 #include <utils/options.hpp>
@@ -74,6 +76,21 @@ static nr::gnb::GnbConfig *ReadConfigYaml()
         result->nssai.slices.push_back(s);
     }
 
+    auto queueConfig = app::ReadQueueConfig(config);
+    result->queueCapacity = queueConfig.capacity;
+    result->queuePolicy = queueConfig.policy;
+
+    // The UEs measure the cells every 2 seconds, hence they must receive at least one beacon in this interval
+    result->beaconPeriod = 0;
+    if (yaml::HasField(config, "beaconPeriod"))
+        result->beaconPeriod = yaml::GetInt32(config, "beaconPeriod", 100, 1000);
+
+    result->udpBatchSize = cons::DefaultUdpBatchSize;
+    if (yaml::HasField(config, "udpBatchSize"))
+        result->udpBatchSize = yaml::GetInt32(config, "udpBatchSize", 1, cons::MaxUdpBatchSize);
+
+    logging::Configure(app::ReadLogConfig(config));
+
     return result;
 }
 
@@ -17,12 +17,17 @@
 #include <utils/common.hpp>
 #include <utils/printer.hpp>
 
-#define PAUSE_CONFIRM_TIMEOUT 3000
-#define PAUSE_POLLING 10
-
 namespace nr::gnb
 {
 
+static Json ToJson(const udp::UdpServerCounters &counters)
+{
+    return Json::Obj({
+        {"send-dropped", static_cast<int64_t>(counters.sendDropped.load())},
+        {"receive-truncated", static_cast<int64_t>(counters.receiveTruncated.load())},
+    });
+}
+
 void GnbCmdHandler::sendResult(const InetAddress &address, const std::string &output)
 {
     m_base->cliCallbackTask->push(new app::NwCliSendResponse(address, output, false));
@@ -33,71 +38,7 @@ void GnbCmdHandler::sendError(const InetAddress &address, const std::string &out
     m_base->cliCallbackTask->push(new app::NwCliSendResponse(address, output, true));
 }
 
-void GnbCmdHandler::pauseTasks()
-{
-    m_base->gtpTask->requestPause();
-    m_base->rlsTask->requestPause();
-    m_base->ngapTask->requestPause();
-    m_base->rrcTask->requestPause();
-    m_base->sctpTask->requestPause();
-}
-
-void GnbCmdHandler::unpauseTasks()
-{
-    m_base->gtpTask->requestUnpause();
-    m_base->rlsTask->requestUnpause();
-    m_base->ngapTask->requestUnpause();
-    m_base->rrcTask->requestUnpause();
-    m_base->sctpTask->requestUnpause();
-}
-
-bool GnbCmdHandler::isAllPaused()
-{
-    if (!m_base->gtpTask->isPauseConfirmed())
-        return false;
-    if (!m_base->rlsTask->isPauseConfirmed())
-        return false;
-    if (!m_base->ngapTask->isPauseConfirmed())
-        return false;
-    if (!m_base->rrcTask->isPauseConfirmed())
-        return false;
-    if (!m_base->sctpTask->isPauseConfirmed())
-        return false;
-    return true;
-}
-
 void GnbCmdHandler::handleCmd(NwGnbCliCommand &msg)
-{
-    pauseTasks();
-
-    uint64_t currentTime = utils::CurrentTimeMillis();
-    uint64_t endTime = currentTime + PAUSE_CONFIRM_TIMEOUT;
-
-    bool isPaused = false;
-    while (currentTime < endTime)
-    {
-        currentTime = utils::CurrentTimeMillis();
-        if (isAllPaused())
-        {
-            isPaused = true;
-            break;
-        }
-        utils::Sleep(PAUSE_POLLING);
-    }
-
-    if (!isPaused)
-    {
-        sendError(msg.address, "gNB is unable process command due to pausing timeout");
-    }
-    else
-    {
-        handleCmdImpl(msg);
-    }
-
-    unpauseTasks();
-}
-
-void GnbCmdHandler::handleCmdImpl(NwGnbCliCommand &msg)
 {
     switch (msg.cmd->present)
     {
@@ -109,6 +50,39 @@ void GnbCmdHandler::handleCmdImpl(NwGnbCliCommand &msg)
         sendResult(msg.address, ToJson(*m_base->config).dumpYaml());
         break;
     }
+    case app::GnbCliCommand::AMF_LIST:
+    case app::GnbCliCommand::AMF_INFO:
+    case app::GnbCliCommand::UE_LIST:
+    case app::GnbCliCommand::UE_COUNT:
+    case app::GnbCliCommand::UE_RELEASE_REQ: {
+        m_base->ngapTask->push(new NwGnbCliCommand(std::move(msg.cmd), msg.address));
+        break;
+    }
+    case app::GnbCliCommand::QUEUE_STATS: {
+        Json json = Json::Obj({
+            {"app", ToJson(m_base->appTask->getQueueStats())},
+            {"sctp", ToJson(m_base->sctpTask->getQueueStats())},
+            {"ngap", ToJson(m_base->ngapTask->getQueueStats())},
+            {"rrc", ToJson(m_base->rrcTask->getQueueStats())},
+            {"gtp", ToJson(m_base->gtpTask->getQueueStats())},
+            {"rls", ToJson(m_base->rlsTask->getQueueStats())},
+            {"gtp-udp", ToJson(m_base->gtpTask->m_udpCounters)},
+            {"rls-udp", ToJson(m_base->rlsTask->m_udpCounters)},
+        });
+        sendResult(msg.address, json.dumpYaml());
+        break;
+    }
+    case app::GnbCliCommand::ALLOC_STATS: {
+        sendResult(msg.address, ToJson(NtsMessage::AllocatorStats()).dumpYaml());
+        break;
+    }
+    }
+}
+
+void GnbCmdHandler::handleNgapCmd(NwGnbCliCommand &msg)
+{
+    switch (msg.cmd->present)
+    {
     case app::GnbCliCommand::AMF_LIST: {
         Json json = Json::Arr({});
         for (auto &amf : m_base->ngapTask->m_amfCtx)
@@ -154,6 +128,8 @@ void GnbCmdHandler::handleCmdImpl(NwGnbCliCommand &msg)
         }
         break;
     }
+    default:
+        break;
     }
 }
 
@@ -24,15 +24,10 @@ class GnbCmdHandler
     {
     }
 
+    // - Each command is handled by the task owning the state it reads or modifies, so the tasks are never paused.
+    // - handleCmd() is called by the App task, which forwards the command to the owning task if needed.
     void handleCmd(NwGnbCliCommand &msg);
-
-  private:
-    void pauseTasks();
-    void unpauseTasks();
-    bool isAllPaused();
-
-  private:
-    void handleCmdImpl(NwGnbCliCommand &msg);
+    void handleNgapCmd(NwGnbCliCommand &msg);
 
   private:
     void sendResult(const InetAddress &address, const std::string &output);
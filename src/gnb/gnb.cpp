@@ -23,7 +23,7 @@ GNodeB::GNodeB(GnbConfig *config, app::INodeListener *nodeListener, NtsTask *cli
 {
     auto *base = new TaskBase();
     base->config = config;
-    base->logBase = new LogBase("logs/" + config->name + ".log");
+    base->logBase = LogBase::Shared();
     base->nodeListener = nodeListener;
     base->cliCallbackTask = cliCallbackTask;
 
@@ -34,6 +34,10 @@ GNodeB::GNodeB(GnbConfig *config, app::INodeListener *nodeListener, NtsTask *cli
     base->gtpTask = new GtpTask(base);
     base->rlsTask = new GnbRlsTask(base);
 
+    // Bound the mailboxes of the data plane tasks
+    base->gtpTask->setQueueCapacity(config->queueCapacity, config->queuePolicy);
+    base->rlsTask->setQueueCapacity(config->queueCapacity, config->queuePolicy);
+
     taskBase = base;
 }
 
@@ -53,8 +57,6 @@ GNodeB::~GNodeB()
     delete taskBase->gtpTask;
     delete taskBase->rlsTask;
 
-    delete taskBase->logBase;
-
     delete taskBase;
 }
 
@@ -15,11 +15,13 @@
 
 #include <asn/ngap/ASN_NGAP_QosFlowSetupRequestItem.h>
 
+#define MSG_BATCH_SIZE 64
+
 namespace nr::gnb
 {
 
 GtpTask::GtpTask(TaskBase *base)
-    : m_base{base}, m_udpServer{}, m_ueContexts{},
+    : m_base{base}, m_udpServer{}, m_udpCounters{}, m_ueContexts{},
       m_rateLimiter(std::make_unique<RateLimiter>()), m_pduSessions{}, m_sessionTree{}
 {
     m_logger = m_base->logBase->makeUniqueLogger("gtp");
@@ -29,7 +31,8 @@ void GtpTask::onStart()
 {
     try
     {
-        m_udpServer = new udp::UdpServerTask(m_base->config->gtpIp, cons::GtpPort, this);
+        m_udpServer = new udp::UdpServerTask(m_base->config->gtpIp, cons::GtpPort, this, NtsLane::BULK,
+                                             m_base->config->udpBatchSize, &m_udpCounters);
         m_udpServer->start();
     }
     catch (const LibError &e)
@@ -48,10 +51,18 @@ void GtpTask::onQuit()
 
 void GtpTask::onLoop()
 {
-    NtsMessage *msg = take();
-    if (!msg)
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
         return;
 
+    for (NtsMessage *msg : m_msgBatch)
+        handleMessage(msg);
+
+    if (m_udpServer != nullptr)
+        m_udpServer->flush();
+}
+
+void GtpTask::handleMessage(NtsMessage *msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::GNB_NGAP_TO_GTP: {
@@ -78,7 +89,7 @@ void GtpTask::onLoop()
         break;
     }
     case NtsMessageType::GNB_RLS_TO_GTP: {
-        auto *w = dynamic_cast<NwGnbRlsToGtp *>(msg);
+        auto *w = NtsCast<NwGnbRlsToGtp>(msg);
         switch (w->present)
         {
         case NwGnbRlsToGtp::DATA_PDU_DELIVERY: {
@@ -89,7 +100,7 @@ void GtpTask::onLoop()
         break;
     }
     case NtsMessageType::UDP_SERVER_RECEIVE:
-        handleUdpReceive(*dynamic_cast<udp::NwUdpServerReceive *>(msg));
+        handleUdpReceive(*NtsCast<udp::NwUdpServerReceive>(msg));
         break;
     default:
         m_logger->unhandledNts(msg);
@@ -214,7 +225,7 @@ void GtpTask::handleUplinkData(int ueId, int psi, OctetString &&pdu)
         if (!gtp::EncodeGtpMessage(gtp, gtpPdu))
             m_logger->err("Uplink data failure, GTP encoding failed");
         else
-            m_udpServer->send(InetAddress(pduSession->upTunnel.address, cons::GtpPort), gtpPdu);
+            m_udpServer->enqueue(InetAddress(pduSession->upTunnel.address, cons::GtpPort), gtpPdu);
     }
 }
 
@@ -244,7 +255,7 @@ void GtpTask::handleUdpReceive(const udp::NwUdpServerReceive &msg)
         w->ueId = GetUeId(sessionInd);
         w->psi = GetPsi(sessionInd);
         w->pdu = std::move(gtp->payload);
-        m_base->rlsTask->push(w);
+        m_base->rlsTask->push(w, NtsLane::BULK);
     }
 
     delete gtp;
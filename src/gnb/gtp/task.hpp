@@ -30,10 +30,12 @@ class GtpTask : public NtsTask
     std::unique_ptr<Logger> m_logger;
 
     udp::UdpServerTask *m_udpServer;
+    udp::UdpServerCounters m_udpCounters; // Read by the CLI, hence kept for the lifetime of the task
     std::unordered_map<int, std::unique_ptr<GtpUeContext>> m_ueContexts;
     std::unique_ptr<IRateLimiter> m_rateLimiter;
     std::unordered_map<uint64_t, std::unique_ptr<PduSessionResource>> m_pduSessions;
     PduSessionTree m_sessionTree;
+    std::vector<NtsMessage *> m_msgBatch{};
 
     friend class GnbCmdHandler;
 
@@ -46,6 +48,9 @@ class GtpTask : public NtsTask
     void onLoop() override;
     void onQuit() override;
 
+  private:
+    void handleMessage(NtsMessage *msg);
+
   private:
     void handleUdpReceive(const udp::NwUdpServerReceive &msg);
     void handleUeContextUpdate(const GtpUeContextUpdate &msg);
@@ -10,6 +10,7 @@
 
 #include <sstream>
 
+#include <gnb/app/cmd_handler.hpp>
 #include <gnb/app/task.hpp>
 #include <gnb/sctp/task.hpp>
 
@@ -88,6 +89,12 @@ void NgapTask::onLoop()
         }
         break;
     }
+    case NtsMessageType::GNB_CLI_COMMAND: {
+        auto *w = dynamic_cast<NwGnbCliCommand *>(msg);
+        GnbCmdHandler handler{m_base};
+        handler.handleNgapCmd(*w);
+        break;
+    }
     default: {
         m_logger->unhandledNts(msg);
         break;
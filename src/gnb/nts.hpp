@@ -52,7 +52,7 @@ struct NwGnbRlsToRrc : NtsMessage
     }
 };
 
-struct NwGnbRlsToGtp : NtsMessage
+struct NwGnbRlsToGtp final : NtsPooledMessage<NwGnbRlsToGtp, NtsMessageType::GNB_RLS_TO_GTP>
 {
     enum PR
     {
@@ -64,12 +64,12 @@ struct NwGnbRlsToGtp : NtsMessage
     int psi{};
     OctetString pdu{};
 
-    explicit NwGnbRlsToGtp(PR present) : NtsMessage(NtsMessageType::GNB_RLS_TO_GTP), present(present)
+    explicit NwGnbRlsToGtp(PR present) : present(present)
     {
     }
 };
 
-struct NwGnbGtpToRls : NtsMessage
+struct NwGnbGtpToRls final : NtsPooledMessage<NwGnbGtpToRls, NtsMessageType::GNB_GTP_TO_RLS>
 {
     enum PR
     {
@@ -81,7 +81,7 @@ struct NwGnbGtpToRls : NtsMessage
     int psi{};
     OctetString pdu{};
 
-    explicit NwGnbGtpToRls(PR present) : NtsMessage(NtsMessageType::GNB_GTP_TO_RLS), present(present)
+    explicit NwGnbGtpToRls(PR present) : present(present)
     {
     }
 };
@@ -33,6 +33,8 @@ namespace nr::gnb
 void GnbRlsTask::handleCellInfoRequest(int ueId, const rls::RlsCellInfoRequest &msg)
 {
     int dbm = EstimateSimulatedDbm(m_base->config->phyLocation, msg.simPos);
+    m_ueCtx[ueId]->dbm = dbm;
+
     if (dbm < MIN_ALLOWED_DBM)
     {
         // if the simulated signal strength is such low, then do not send a response to this message
@@ -50,6 +52,35 @@ void GnbRlsTask::handleCellInfoRequest(int ueId, const rls::RlsCellInfoRequest &
     sendRlsMessage(ueId, resp);
 }
 
+void GnbRlsTask::sendBeacons()
+{
+    if (!m_powerOn)
+        return;
+
+    // The beacon is encoded once, and only the target STI and the signal strength are set for each UE
+    if (m_beacon.length() == 0)
+    {
+        rls::RlsCellInfoResponse resp{m_sti};
+        resp.cellId.nci = m_base->config->nci;
+        resp.cellId.plmn = m_base->config->plmn;
+        resp.tac = m_base->config->tac;
+        resp.gnbName = m_base->config->name;
+        resp.linkIp = m_base->config->portalIp;
+
+        rls::EncodeRlsMessage(resp, m_beacon);
+    }
+
+    for (auto &item : m_ueCtx)
+    {
+        auto &ctx = *item.second;
+        if (ctx.dbm < MIN_ALLOWED_DBM)
+            continue;
+
+        rls::PatchCellInfoResponse(m_beacon, ctx.sti, ctx.dbm);
+        m_udpTask->enqueue(ctx.addr, m_beacon);
+    }
+}
+
 void GnbRlsTask::handleUplinkPduDelivery(int ueId, rls::RlsPduDelivery &msg)
 {
     if (msg.pduType == rls::EPduType::RRC)
@@ -66,7 +97,7 @@ void GnbRlsTask::handleUplinkPduDelivery(int ueId, rls::RlsPduDelivery &msg)
         nw->ueId = ueId;
         nw->psi = msg.payload.get4I(0);
         nw->pdu = std::move(msg.pdu);
-        m_base->gtpTask->push(nw);
+        m_base->gtpTask->push(nw, NtsLane::BULK);
     }
 }
 
@@ -14,6 +14,8 @@
 #include <utils/common.hpp>
 
 static const int64_t LAST_SEEN_THRESHOLD = 3000;
+// The UEs listening to the beacons are seen only once in a keepalive period
+static const int64_t LAST_SEEN_THRESHOLD_BEACON = rls::BEACON_KEEPALIVE_PERIOD * 5 / 2;
 
 namespace nr::gnb
 {
@@ -46,13 +48,14 @@ int GnbRlsTask::updateUeInfo(const InetAddress &addr, uint64_t sti)
 void GnbRlsTask::onPeriodicLostControl()
 {
     int64_t current = utils::CurrentTimeMillis();
+    int64_t threshold = m_base->config->beaconPeriod > 0 ? LAST_SEEN_THRESHOLD_BEACON : LAST_SEEN_THRESHOLD;
 
     std::set<int> lostUeId{};
     std::set<uint64_t> lostSti{};
 
     for (auto &item : m_ueCtx)
     {
-        if (current - item.second->lastSeen > LAST_SEEN_THRESHOLD)
+        if (current - item.second->lastSeen > threshold)
         {
             lostUeId.insert(item.second->ueId);
             lostSti.insert(item.second->sti);
@@ -17,12 +17,15 @@
 
 static const int TIMER_ID_LOST_CONTROL = 1;
 static const int TIMER_PERIOD_LOST_CONTROL = 2000;
+static const int TIMER_ID_BEACON = 2;
+
+static const int MSG_BATCH_SIZE = 64;
 
 namespace nr::gnb
 {
 
 GnbRlsTask::GnbRlsTask(TaskBase *base)
-    : m_base{base}, m_udpTask{}, m_powerOn{}, m_ueCtx{}, m_stiToUeId{}, m_ueIdCounter{}
+    : m_base{base}, m_udpTask{}, m_udpCounters{}, m_powerOn{}, m_beaconTimer{}, m_ueCtx{}, m_stiToUeId{}, m_ueIdCounter{}
 {
     m_logger = m_base->logBase->makeUniqueLogger("rls");
     m_sti = utils::Random64();
@@ -32,7 +35,8 @@ void GnbRlsTask::onStart()
 {
     try
     {
-        m_udpTask = new udp::UdpServerTask(m_base->config->portalIp, cons::PortalPort, this);
+        m_udpTask = new udp::UdpServerTask(m_base->config->portalIp, cons::PortalPort, this, NtsLane::CONTROL,
+                                           m_base->config->udpBatchSize, &m_udpCounters);
         m_udpTask->start();
     }
     catch (const LibError &e)
@@ -42,15 +46,23 @@ void GnbRlsTask::onStart()
         return;
     }
 
-    setTimer(TIMER_ID_LOST_CONTROL, TIMER_PERIOD_LOST_CONTROL);
+    setPeriodicTimer(TIMER_ID_LOST_CONTROL, TIMER_PERIOD_LOST_CONTROL);
 }
 
 void GnbRlsTask::onLoop()
 {
-    NtsMessage *msg = take();
-    if (!msg)
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
         return;
 
+    for (NtsMessage *msg : m_msgBatch)
+        handleMessage(msg);
+
+    if (m_udpTask != nullptr)
+        m_udpTask->flush();
+}
+
+void GnbRlsTask::handleMessage(NtsMessage *msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::GNB_RRC_TO_RLS: {
@@ -64,13 +76,16 @@ void GnbRlsTask::onLoop()
         }
         case NwGnbRrcToRls::RADIO_POWER_ON: {
             m_powerOn = true;
+            // The beacons are useless until the cell is on air
+            if (m_base->config->beaconPeriod > 0 && m_beaconTimer == 0)
+                m_beaconTimer = setPeriodicTimer(TIMER_ID_BEACON, m_base->config->beaconPeriod);
             break;
         }
         }
         break;
     }
     case NtsMessageType::GNB_GTP_TO_RLS: {
-        auto *w = dynamic_cast<NwGnbGtpToRls *>(msg);
+        auto *w = NtsCast<NwGnbGtpToRls>(msg);
         switch (w->present)
         {
         case NwGnbGtpToRls::DATA_PDU_DELIVERY: {
@@ -82,7 +97,7 @@ void GnbRlsTask::onLoop()
         break;
     }
     case NtsMessageType::UDP_SERVER_RECEIVE: {
-        auto *w = dynamic_cast<udp::NwUdpServerReceive *>(msg);
+        auto *w = NtsCast<udp::NwUdpServerReceive>(msg);
         auto rlsMsg = rls::DecodeRlsMessage(OctetView{w->packet});
         if (rlsMsg == nullptr)
         {
@@ -95,10 +110,9 @@ void GnbRlsTask::onLoop()
     case NtsMessageType::TIMER_EXPIRED: {
         auto *w = dynamic_cast<NwTimerExpired *>(msg);
         if (w->timerId == TIMER_ID_LOST_CONTROL)
-        {
-            setTimer(TIMER_ID_LOST_CONTROL, TIMER_PERIOD_LOST_CONTROL);
             onPeriodicLostControl();
-        }
+        else if (w->timerId == TIMER_ID_BEACON)
+            sendBeacons();
         break;
     }
     default:
@@ -29,12 +29,16 @@ class GnbRlsTask : public NtsTask
     TaskBase *m_base;
     std::unique_ptr<Logger> m_logger;
     udp::UdpServerTask *m_udpTask;
+    udp::UdpServerCounters m_udpCounters; // Read by the CLI, hence kept for the lifetime of the task
 
     bool m_powerOn;
+    NtsTimerHandle m_beaconTimer;
     uint64_t m_sti;
     std::unordered_map<int, std::unique_ptr<RlsUeContext>> m_ueCtx;
     std::unordered_map<uint64_t, int> m_stiToUeId;
     int m_ueIdCounter;
+    std::vector<NtsMessage *> m_msgBatch{};
+    OctetString m_beacon{};
 
     friend class GnbCmdHandler;
 
@@ -47,12 +51,16 @@ class GnbRlsTask : public NtsTask
     void onLoop() override;
     void onQuit() override;
 
+  private:
+    void handleMessage(NtsMessage *msg);
+
   private: /* Transport */
     void receiveRlsMessage(const InetAddress &addr, rls::RlsMessage &msg);
-    void sendRlsMessage(int ueId, const rls::RlsMessage &msg);
+    void sendRlsMessage(int ueId, rls::RlsMessage &msg);
 
   private: /* Handler */
     void handleCellInfoRequest(int ueId, const rls::RlsCellInfoRequest &msg);
+    void sendBeacons();
     void handleUplinkPduDelivery(int ueId, rls::RlsPduDelivery &msg);
     void handleDownlinkDelivery(int ueId, rls::EPduType pduType, OctetString &&pdu, OctetString &&payload);
 
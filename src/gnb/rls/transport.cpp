@@ -37,7 +37,7 @@ void GnbRlsTask::receiveRlsMessage(const InetAddress &addr, rls::RlsMessage &msg
     }
 }
 
-void GnbRlsTask::sendRlsMessage(int ueId, const rls::RlsMessage &msg)
+void GnbRlsTask::sendRlsMessage(int ueId, rls::RlsMessage &msg)
 {
     if (!m_ueCtx.count(ueId))
     {
@@ -45,9 +45,11 @@ void GnbRlsTask::sendRlsMessage(int ueId, const rls::RlsMessage &msg)
         return;
     }
 
+    msg.targetSti = m_ueCtx[ueId]->sti;
+
     OctetString stream{};
     rls::EncodeRlsMessage(msg, stream);
-    m_udpTask->send(m_ueCtx[ueId]->addr, stream);
+    m_udpTask->enqueue(m_ueCtx[ueId]->addr, stream);
 }
 
 } // namespace nr::gnb
@@ -110,6 +110,7 @@ struct RlsUeContext
     uint64_t sti{};
     InetAddress addr{};
     int64_t lastSeen{};
+    int dbm{}; // Simulated signal strength in the last cell info request, used in the beacons
 
     explicit RlsUeContext(int ueId) : ueId(ueId)
     {
@@ -308,6 +309,10 @@ struct GnbConfig
     std::string ngapIp{};
     std::string gtpIp{};
     bool ignoreStreamIds{};
+    size_t queueCapacity{};
+    NtsOverflowPolicy queuePolicy{};
+    int beaconPeriod{}; // ms, zero if the cell info is not broadcast
+    int udpBatchSize{}; // Datagrams received or sent at once by the RLS and GTP-U sockets
 
     /* Assigned by program */
     std::string name{};
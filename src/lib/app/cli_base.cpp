@@ -23,6 +23,11 @@ InetAddress CliServer::assignedAddress() const
     return m_socket.getAddress();
 }
 
+const Socket &CliServer::socket() const
+{
+    return m_socket;
+}
+
 CliMessage CliServer::receiveMessage()
 {
     uint8_t buffer[CMD_BUFFER_SIZE] = {0};
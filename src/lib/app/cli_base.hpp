@@ -92,6 +92,7 @@ class CliServer
     }
 
     [[nodiscard]] InetAddress assignedAddress() const;
+    [[nodiscard]] const Socket &socket() const;
 
     CliMessage receiveMessage();
     void sendMessage(const CliMessage &msg);
@@ -152,6 +152,8 @@ static OrderedMap<std::string, CmdEntry> g_gnbCmdEntries = {
     {"ue-list", {"List all UEs associated with the gNB", "", DefaultDesc, false}},
     {"ue-count", {"Print the total number of UEs connected the this gNB", "", DefaultDesc, false}},
     {"ue-release", {"Request a UE context release for the given UE", "<ue-id>", DefaultDesc, false}},
+    {"queue-stats", {"Show message queue and UDP socket statistics of the gNB tasks", "", DefaultDesc, false}},
+    {"alloc-stats", {"Show message allocator statistics of the gNB process", "", DefaultDesc, false}},
 };
 
 static OrderedMap<std::string, CmdEntry> g_ueCmdEntries = {
@@ -165,6 +167,9 @@ static OrderedMap<std::string, CmdEntry> g_ueCmdEntries = {
     {"deregister",
      {"Perform a de-registration by the UE", "<normal|disable-5g|switch-off|remove-sim>", DefaultDesc, true}},
     {"coverage", {"Show gNodeB cell coverage information", "", DefaultDesc, false}},
+    {"queue-stats", {"Show message queue statistics of the UE tasks", "", DefaultDesc, false}},
+    {"alloc-stats", {"Show message allocator statistics of the UE process", "", DefaultDesc, false}},
+    {"memory", {"Show estimated memory usage of the UE by component", "", DefaultDesc, false}},
 };
 
 static std::unique_ptr<GnbCliCommand> GnbCliParseImpl(const std::string &subCmd, const opt::OptionsResult &options,
@@ -214,6 +219,14 @@ static std::unique_ptr<GnbCliCommand> GnbCliParseImpl(const std::string &subCmd,
             CMD_ERR("Invalid UE ID")
         return cmd;
     }
+    else if (subCmd == "queue-stats")
+    {
+        return std::make_unique<GnbCliCommand>(GnbCliCommand::QUEUE_STATS);
+    }
+    else if (subCmd == "alloc-stats")
+    {
+        return std::make_unique<GnbCliCommand>(GnbCliCommand::ALLOC_STATS);
+    }
 
     return nullptr;
 }
@@ -320,6 +333,18 @@ static std::unique_ptr<UeCliCommand> UeCliParseImpl(const std::string &subCmd, c
     {
         return std::make_unique<UeCliCommand>(UeCliCommand::COVERAGE);
     }
+    else if (subCmd == "queue-stats")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::QUEUE_STATS);
+    }
+    else if (subCmd == "alloc-stats")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::ALLOC_STATS);
+    }
+    else if (subCmd == "memory")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::MEMORY);
+    }
 
     return nullptr;
 }
@@ -29,6 +29,8 @@ struct GnbCliCommand
         UE_LIST,
         UE_COUNT,
         UE_RELEASE_REQ,
+        QUEUE_STATS,
+        ALLOC_STATS,
     } present;
 
     // AMF_INFO
@@ -54,6 +56,9 @@ struct UeCliCommand
         PS_RELEASE_ALL,
         DE_REGISTER,
         COVERAGE,
+        QUEUE_STATS,
+        ALLOC_STATS,
+        MEMORY,
     } present;
 
     // DE_REGISTER
@@ -0,0 +1,212 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "launch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <utils/common.hpp>
+
+namespace app
+{
+
+static double ParseNumber(const std::string &key, const std::string &value)
+{
+    try
+    {
+        size_t pos = 0;
+        double res = std::stod(value, &pos);
+        if (pos == value.size() && std::isfinite(res) && res >= 0)
+            return res;
+    }
+    catch (const std::logic_error &)
+    {
+    }
+    throw std::runtime_error("Invalid launch profile value for " + key + ": " + value);
+}
+
+ELaunchProfile ParseLaunchProfileType(const std::string &name)
+{
+    if (name == "immediate")
+        return ELaunchProfile::IMMEDIATE;
+    if (name == "constant")
+        return ELaunchProfile::CONSTANT;
+    if (name == "ramp")
+        return ELaunchProfile::RAMP;
+    if (name == "poisson")
+        return ELaunchProfile::POISSON;
+    if (name == "burst")
+        return ELaunchProfile::BURST;
+    throw std::runtime_error("Invalid launch profile: " + name);
+}
+
+std::string LaunchProfileName(ELaunchProfile profile)
+{
+    switch (profile)
+    {
+    case ELaunchProfile::IMMEDIATE:
+        return "immediate";
+    case ELaunchProfile::CONSTANT:
+        return "constant";
+    case ELaunchProfile::RAMP:
+        return "ramp";
+    case ELaunchProfile::POISSON:
+        return "poisson";
+    case ELaunchProfile::BURST:
+        return "burst";
+    default:
+        return "?";
+    }
+}
+
+LaunchProfile ParseLaunchProfile(const std::string &spec)
+{
+    LaunchProfile res{};
+
+    size_t colon = spec.find(':');
+    res.type = ParseLaunchProfileType(spec.substr(0, colon));
+
+    if (colon != std::string::npos)
+    {
+        std::stringstream ss{spec.substr(colon + 1)};
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            utils::Trim(item);
+            if (item.empty())
+                continue;
+
+            size_t eq = item.find('=');
+            if (eq == std::string::npos)
+                throw std::runtime_error("Invalid launch profile parameter: " + item);
+
+            std::string key = item.substr(0, eq);
+            std::string value = item.substr(eq + 1);
+            utils::Trim(key);
+            utils::Trim(value);
+
+            if (key == "rate")
+                res.rate = ParseNumber(key, value);
+            else if (key == "start-rate")
+                res.startRate = ParseNumber(key, value);
+            else if (key == "duration")
+                res.rampDuration = static_cast<int64_t>(ParseNumber(key, value));
+            else if (key == "burst-size")
+                res.burstSize = static_cast<int>(ParseNumber(key, value));
+            else if (key == "burst-interval")
+                res.burstInterval = static_cast<int64_t>(ParseNumber(key, value));
+            else if (key == "jitter")
+                res.jitter = static_cast<int64_t>(ParseNumber(key, value));
+            else if (key == "seed")
+                res.seed = static_cast<uint64_t>(ParseNumber(key, value));
+            else
+                throw std::runtime_error("Invalid launch profile parameter: " + key);
+        }
+    }
+
+    ValidateLaunchProfile(res);
+    return res;
+}
+
+void ValidateLaunchProfile(const LaunchProfile &profile)
+{
+    switch (profile.type)
+    {
+    case ELaunchProfile::CONSTANT:
+    case ELaunchProfile::POISSON:
+        if (profile.rate <= 0)
+            throw std::runtime_error("Launch profile requires a positive rate");
+        break;
+    case ELaunchProfile::RAMP:
+        if (profile.rate <= 0)
+            throw std::runtime_error("Launch profile requires a positive rate");
+        if (profile.startRate < 0)
+            throw std::runtime_error("Invalid launch profile start rate");
+        if (profile.rampDuration <= 0)
+            throw std::runtime_error("Launch profile requires a positive ramp duration");
+        break;
+    case ELaunchProfile::BURST:
+        if (profile.burstSize <= 0)
+            throw std::runtime_error("Launch profile requires a positive burst size");
+        if (profile.burstInterval <= 0)
+            throw std::runtime_error("Launch profile requires a positive burst interval");
+        break;
+    default:
+        break;
+    }
+
+    if (profile.jitter < 0)
+        throw std::runtime_error("Invalid launch profile jitter");
+}
+
+// Time in seconds at which the cumulative number of launches of the ramp profile reaches n
+static double RampTime(const LaunchProfile &profile, double n)
+{
+    double r0 = profile.startRate;
+    double r1 = profile.rate;
+    double d = static_cast<double>(profile.rampDuration) / 1000.0;
+
+    // During the ramp, the cumulative number of launches is r0*t + a*t^2
+    double a = (r1 - r0) / (2.0 * d);
+    double rampCount = r0 * d + a * d * d;
+    if (n > rampCount)
+        return d + (n - rampCount) / r1;
+    if (a == 0)
+        return n / r0;
+    return (-r0 + std::sqrt(r0 * r0 + 4.0 * a * n)) / (2.0 * a);
+}
+
+std::vector<int64_t> ComputeLaunchTimes(const LaunchProfile &profile, int count)
+{
+    std::vector<int64_t> res(static_cast<size_t>(std::max(count, 0)));
+
+    std::mt19937_64 randomEngine{profile.seed};
+    std::exponential_distribution<double> interArrival{profile.rate > 0 ? profile.rate : 1.0};
+    double poissonTime = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        double seconds = 0;
+        switch (profile.type)
+        {
+        case ELaunchProfile::CONSTANT:
+            seconds = i / profile.rate;
+            break;
+        case ELaunchProfile::RAMP:
+            seconds = RampTime(profile, i);
+            break;
+        case ELaunchProfile::POISSON:
+            if (i > 0)
+                poissonTime += interArrival(randomEngine);
+            seconds = poissonTime;
+            break;
+        case ELaunchProfile::BURST:
+            seconds = static_cast<double>((i / profile.burstSize) * profile.burstInterval) / 1000.0;
+            break;
+        default:
+            break;
+        }
+
+        res[i] = static_cast<int64_t>(seconds * 1000.0);
+    }
+
+    if (profile.jitter > 0)
+    {
+        std::uniform_int_distribution<int64_t> jitter{0, profile.jitter};
+        for (auto &time : res)
+            time += jitter(randomEngine);
+    }
+
+    return res;
+}
+
+} // namespace app
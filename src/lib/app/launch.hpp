@@ -0,0 +1,52 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace app
+{
+
+enum class ELaunchProfile
+{
+    IMMEDIATE, // All at once
+    CONSTANT,  // Fixed rate
+    RAMP,      // Rate increases linearly from startRate to rate during rampDuration, then stays constant
+    POISSON,   // Exponentially distributed inter-arrival times with the mean rate
+    BURST,     // burstSize UEs at every burstInterval
+};
+
+struct LaunchProfile
+{
+    ELaunchProfile type{};
+    double rate{};          // UEs per second
+    double startRate{};     // UEs per second
+    int64_t rampDuration{}; // ms
+    int burstSize{};
+    int64_t burstInterval{}; // ms
+    int64_t jitter{};        // ms, uniformly distributed extra delay of each UE
+    uint64_t seed{};         // The same seed gives the same launch times
+};
+
+// Parses a profile given as "<profile>[:<key>=<value>,...]", e.g. "ramp:start-rate=1,rate=100,duration=60000".
+// - The keys are rate, start-rate, duration, burst-size, burst-interval, jitter and seed.
+// - Throws std::runtime_error for invalid specifications.
+LaunchProfile ParseLaunchProfile(const std::string &spec);
+ELaunchProfile ParseLaunchProfileType(const std::string &name);
+// Throws std::runtime_error if a parameter needed by the profile is missing or invalid.
+void ValidateLaunchProfile(const LaunchProfile &profile);
+
+// Returns the launch time of each UE relative to the start of the launch, in ms.
+std::vector<int64_t> ComputeLaunchTimes(const LaunchProfile &profile, int count);
+
+std::string LaunchProfileName(ELaunchProfile profile);
+
+} // namespace app
@@ -0,0 +1,62 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "logging.hpp"
+
+#include <stdexcept>
+
+#include <utils/yaml_utils.hpp>
+#include <yaml-cpp/yaml.h>
+
+namespace app
+{
+
+static Severity ParseSeverity(const std::string &level)
+{
+    if (level == "debug")
+        return Severity::DEBUG;
+    if (level == "info")
+        return Severity::INFO;
+    if (level == "warn")
+        return Severity::WARN;
+    if (level == "error")
+        return Severity::ERR;
+    throw std::runtime_error("Invalid log level: " + level);
+}
+
+LogConfig ReadLogConfig(const YAML::Node &config)
+{
+    LogConfig result{};
+    if (!yaml::HasField(config, "logging"))
+        return result;
+
+    auto logging = config["logging"];
+
+    if (yaml::HasField(logging, "sink"))
+    {
+        std::string sink = yaml::GetString(logging, "sink");
+        if (sink != "console" && sink != "file" && sink != "both")
+            throw std::runtime_error("Invalid log sink: " + sink);
+        result.console = sink != "file";
+        if (sink != "console")
+            result.file = yaml::GetString(logging, "file", 1, std::nullopt);
+    }
+
+    if (yaml::HasField(logging, "level"))
+        result.level = ParseSeverity(yaml::GetString(logging, "level"));
+
+    if (yaml::HasField(logging, "components"))
+    {
+        for (const auto &item : logging["components"])
+            result.componentLevels[item.first.as<std::string>()] = ParseSeverity(item.second.as<std::string>());
+    }
+
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,24 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <utils/logger.hpp>
+
+namespace YAML
+{
+class Node;
+}
+
+namespace app
+{
+
+// Reads the optional 'logging' section of a node configuration
+LogConfig ReadLogConfig(const YAML::Node &config);
+
+} // namespace app
@@ -0,0 +1,47 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "queue_config.hpp"
+
+#include <stdexcept>
+
+#include <utils/constants.hpp>
+#include <utils/yaml_utils.hpp>
+#include <yaml-cpp/yaml.h>
+
+namespace app
+{
+
+static NtsOverflowPolicy ParsePolicy(const std::string &policy)
+{
+    if (policy == "block")
+        return NtsOverflowPolicy::BLOCK;
+    if (policy == "drop-newest")
+        return NtsOverflowPolicy::DROP_NEWEST;
+    if (policy == "drop-oldest")
+        return NtsOverflowPolicy::DROP_OLDEST;
+    if (policy == "drop-bulk")
+        return NtsOverflowPolicy::DROP_BULK;
+    throw std::runtime_error("Invalid queue policy: " + policy);
+}
+
+QueueConfig ReadQueueConfig(const YAML::Node &config)
+{
+    QueueConfig result{};
+    result.capacity = cons::DefaultQueueCapacity;
+    result.policy = NtsOverflowPolicy::DROP_BULK;
+
+    if (yaml::HasField(config, "queueCapacity"))
+        result.capacity = static_cast<size_t>(yaml::GetInt32(config, "queueCapacity", 0, std::nullopt));
+    if (yaml::HasField(config, "queuePolicy"))
+        result.policy = ParsePolicy(yaml::GetString(config, "queuePolicy"));
+
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,33 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+
+#include <utils/nts.hpp>
+
+namespace YAML
+{
+class Node;
+}
+
+namespace app
+{
+
+// Mailbox bound of the data plane tasks of a node
+struct QueueConfig
+{
+    size_t capacity{};
+    NtsOverflowPolicy policy{};
+};
+
+// Reads the optional 'queueCapacity' and 'queuePolicy' fields of a node configuration
+QueueConfig ReadQueueConfig(const YAML::Node &config);
+
+} // namespace app
@@ -0,0 +1,314 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "workers.hpp"
+#include "base_app.hpp"
+#include "cli_base.hpp"
+#include "proc_table.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+
+#define RELAY_TIMEOUT 10000
+#define SELECT_TIMEOUT 1000
+
+namespace app
+{
+
+static std::vector<int> g_workerPids{};
+
+static void TerminateWorkers()
+{
+    for (int pid : g_workerPids)
+    {
+        if (pid > 0)
+            ::kill(pid, SIGTERM);
+    }
+}
+
+static void PinToCpu(int worker)
+{
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (::sched_getaffinity(0, sizeof(available), &available) != 0)
+        return;
+
+    std::vector<int> cpus{};
+    for (int i = 0; i < CPU_SETSIZE; i++)
+    {
+        if (CPU_ISSET(i, &available))
+            cpus.push_back(i);
+    }
+    if (cpus.empty())
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[worker % cpus.size()], &set);
+    ::sched_setaffinity(0, sizeof(set), &set);
+}
+
+static std::string ReadReport(int fd)
+{
+    std::string report{};
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        report.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return report;
+}
+
+// Reaps the exited workers, returns the number of the running ones
+static int ReapWorkers()
+{
+    int running = 0;
+    for (size_t i = 0; i < g_workerPids.size(); i++)
+    {
+        int &pid = g_workerPids[i];
+        if (pid <= 0)
+            continue;
+
+        int status = 0;
+        if (::waitpid(pid, &status, WNOHANG) == pid)
+        {
+            if (WIFSIGNALED(status))
+                std::cerr << "Worker[" << i << "] is terminated by signal " << WTERMSIG(status) << std::endl;
+            else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+                std::cerr << "Worker[" << i << "] exited with status " << WEXITSTATUS(status) << std::endl;
+            pid = 0;
+            continue;
+        }
+        running++;
+    }
+    return running;
+}
+
+struct PendingRelay
+{
+    std::unique_ptr<CliServer> server;
+    InetAddress clientAddr;
+    int64_t deadline;
+};
+
+[[noreturn]] static void RunRelay(const std::unordered_map<std::string, uint16_t> &nodePorts, CliServer *cliServer)
+{
+    std::vector<PendingRelay> pending{};
+
+    while (true)
+    {
+        if (ReapWorkers() == 0)
+            exit(0);
+
+        if (cliServer == nullptr)
+        {
+            ::sleep(1);
+            continue;
+        }
+
+        std::vector<Socket> readSockets{cliServer->socket()};
+        for (auto &relay : pending)
+            readSockets.push_back(relay.server->socket());
+
+        std::vector<Socket> readable{}, writable{};
+        Socket::Select(readSockets, {}, readable, writable, SELECT_TIMEOUT);
+
+        for (auto &socket : readable)
+        {
+            if (socket.getFd() == cliServer->socket().getFd())
+            {
+                auto msg = cliServer->receiveMessage();
+                if (msg.type == CliMessage::Type::ECHO)
+                {
+                    cliServer->sendMessage(msg);
+                    continue;
+                }
+                if (msg.type != CliMessage::Type::COMMAND)
+                    continue;
+
+                auto it = nodePorts.find(msg.nodeName);
+                if (it == nodePorts.end() || it->second == 0)
+                {
+                    cliServer->sendMessage(CliMessage::Error(msg.clientAddr, "Node not found: " + msg.nodeName));
+                    continue;
+                }
+
+                // Each command is relayed over a new socket, so that the response is matched to the client by the
+                // socket it is received from
+                PendingRelay relay{std::make_unique<CliServer>(), msg.clientAddr,
+                                   utils::CurrentTimeMillis() + RELAY_TIMEOUT};
+                relay.server->sendMessage(
+                    CliMessage::Command(InetAddress{cons::CMD_SERVER_IP, it->second}, msg.value, msg.nodeName));
+                pending.push_back(std::move(relay));
+                continue;
+            }
+
+            for (auto &relay : pending)
+            {
+                if (relay.server->socket().getFd() != socket.getFd())
+                    continue;
+
+                auto msg = relay.server->receiveMessage();
+                if (msg.type == CliMessage::Type::RESULT || msg.type == CliMessage::Type::ERROR)
+                {
+                    msg.clientAddr = relay.clientAddr;
+                    cliServer->sendMessage(msg);
+                    relay.deadline = 0;
+                }
+                break;
+            }
+        }
+
+        int64_t current = utils::CurrentTimeMillis();
+        for (auto &relay : pending)
+        {
+            if (relay.deadline != 0 && current > relay.deadline)
+            {
+                cliServer->sendMessage(CliMessage::Error(relay.clientAddr, "No response from the worker process"));
+                relay.deadline = 0;
+            }
+        }
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [](auto &relay) { return relay.deadline == 0; }),
+                      pending.end());
+    }
+}
+
+WorkerPartition RunCoordinator(int workerCount, int nodeCount, bool enableCli)
+{
+    if (workerCount <= 0 || workerCount > nodeCount)
+        throw std::runtime_error("Invalid number of worker processes");
+
+    int coordinatorPid = static_cast<int>(::getpid());
+    std::vector<int> reportFds{};
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) != 0)
+            throw LibError("Worker report pipe could not be created", errno);
+
+        int pid = static_cast<int>(::fork());
+        if (pid < 0)
+        {
+            TerminateWorkers();
+            throw LibError("Worker process could not be forked", errno);
+        }
+
+        if (pid == 0)
+        {
+            // Terminate the worker together with the coordinator
+            ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (static_cast<int>(::getppid()) != coordinatorPid)
+                exit(1);
+
+            ::close(fds[0]);
+            for (int fd : reportFds)
+                ::close(fd);
+            g_workerPids.clear();
+
+            PinToCpu(i);
+
+            WorkerPartition partition{};
+            partition.worker = i;
+            partition.first = static_cast<int>(static_cast<int64_t>(nodeCount) * i / workerCount);
+            partition.count = static_cast<int>(static_cast<int64_t>(nodeCount) * (i + 1) / workerCount) -
+                              partition.first;
+            partition.reportFd = fds[1];
+            return partition;
+        }
+
+        ::close(fds[1]);
+        reportFds.push_back(fds[0]);
+        g_workerPids.push_back(pid);
+    }
+
+    RunAtExit(TerminateWorkers);
+
+    std::vector<std::string> nodes{};
+    std::unordered_map<std::string, uint16_t> nodePorts{};
+    for (int i = 0; i < workerCount; i++)
+    {
+        std::string report = ReadReport(reportFds[i]);
+        if (report.empty())
+        {
+            std::cerr << "ERROR: Worker[" << i << "] could not be started" << std::endl;
+            TerminateWorkers();
+            exit(1);
+        }
+
+        auto entry = ProcTableEntry::Decode(report);
+        for (auto &node : entry.nodes)
+        {
+            nodePorts[node] = entry.port;
+            nodes.push_back(std::move(node));
+        }
+    }
+
+    std::cout << "Running " << nodes.size() << " nodes in " << workerCount << " worker processes" << std::endl;
+
+    CliServer *cliServer = nullptr;
+    if (enableCli)
+    {
+        cliServer = new CliServer{};
+        CreateProcTable(nodes, cliServer->assignedAddress().getPort());
+    }
+
+    RunRelay(nodePorts, cliServer);
+}
+
+void ReportToCoordinator(WorkerPartition &partition, const std::vector<std::string> &nodes, int cmdPort)
+{
+    if (partition.reportFd < 0)
+        return;
+
+    ProcTableEntry entry{};
+    entry.major = cons::Major;
+    entry.minor = cons::Minor;
+    entry.patch = cons::Patch;
+    entry.pid = static_cast<int>(::getpid());
+    entry.port = static_cast<uint16_t>(cmdPort);
+    entry.nodes = nodes;
+
+    std::string report = ProcTableEntry::Encode(entry);
+
+    size_t written = 0;
+    while (written < report.size())
+    {
+        ssize_t n = ::write(partition.reportFd, report.data() + written, report.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        written += static_cast<size_t>(n);
+    }
+
+    ::close(partition.reportFd);
+    partition.reportFd = -1;
+}
+
+} // namespace app
@@ -0,0 +1,38 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace app
+{
+
+// Part of the nodes handled by a worker process
+struct WorkerPartition
+{
+    int worker{};       // Index of the worker
+    int first{};        // Index of the first node
+    int count{};        // Number of nodes
+    int reportFd{-1};   // See ReportToCoordinator
+};
+
+// Forks the given number of worker processes, each one handling a contiguous range of the node indices [0, nodeCount)
+// and pinned to a different CPU while there are enough of them.
+// - Returns the partition of the worker in each worker process.
+// - Never returns in the coordinator process. The coordinator waits for the reports of the workers, creates a single
+//   proc table entry for all nodes, and relays the CLI commands to the worker having the node. It terminates the
+//   workers when it is terminated, and exits once all workers exit.
+// - Must be called before any thread is created. Throws std::runtime_error if the workers cannot be forked.
+WorkerPartition RunCoordinator(int workerCount, int nodeCount, bool enableCli);
+
+// Reports the nodes and the CLI port of a worker once its nodes are created, in place of CreateProcTable().
+void ReportToCoordinator(WorkerPartition &partition, const std::vector<std::string> &nodes, int cmdPort);
+
+} // namespace app
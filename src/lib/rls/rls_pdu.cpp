@@ -10,6 +10,13 @@
 
 #include <utils/constants.hpp>
 
+#include <cstring>
+
+// Compatibility octet, version, message type, STI and target STI
+#define RLS_HEADER_LENGTH (1 + 3 + 1 + 8 + 8)
+// Offset of the signal strength in a cell info response, following the global NCI and the TAC
+#define RLS_CELL_INFO_DBM_OFFSET (RLS_HEADER_LENGTH + 13 + 4)
+
 namespace rls
 {
 
@@ -52,6 +59,7 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
     stream.appendOctet(cons::Patch);
     stream.appendOctet(static_cast<uint8_t>(msg.msgType));
     stream.appendOctet8(msg.sti);
+    stream.appendOctet8(msg.targetSti);
     if (msg.msgType == EMessageType::CELL_INFO_REQUEST)
     {
         auto &m = (const RlsCellInfoRequest &)msg;
@@ -81,6 +89,80 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
     }
 }
 
+static uint8_t *WriteOctet4(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = static_cast<uint8_t>(value >> 24);
+    buffer[1] = static_cast<uint8_t>(value >> 16);
+    buffer[2] = static_cast<uint8_t>(value >> 8);
+    buffer[3] = static_cast<uint8_t>(value);
+    return buffer + 4;
+}
+
+static uint8_t *WriteOctet8(uint8_t *buffer, uint64_t value)
+{
+    WriteOctet4(buffer, static_cast<uint32_t>(value >> 32));
+    return WriteOctet4(buffer + 4, static_cast<uint32_t>(value));
+}
+
+void EncodeRlsPduDelivery(uint64_t sti, EPduType pduType, const OctetString &payload, PacketBuffer &pdu)
+{
+    auto pduLength = static_cast<uint32_t>(pdu.length());
+    auto payloadLength = static_cast<size_t>(payload.length());
+
+    // The PDU is copied once into a new buffer if the lower layers are not given enough space
+    if (pdu.headroom() < PDU_DELIVERY_HEADROOM || pdu.tailroom() < 4 + payloadLength)
+        pdu = PacketBuffer::FromOctetString(pdu.toOctetString(), PDU_DELIVERY_HEADROOM, 4 + payloadLength);
+
+    uint8_t *p = pdu.prepend(PDU_DELIVERY_HEADROOM);
+    *p++ = 0x03; // (Just for old RLS compatibility)
+    *p++ = static_cast<uint8_t>(cons::Major);
+    *p++ = static_cast<uint8_t>(cons::Minor);
+    *p++ = static_cast<uint8_t>(cons::Patch);
+    *p++ = static_cast<uint8_t>(EMessageType::PDU_DELIVERY);
+    p = WriteOctet8(p, sti);
+    p = WriteOctet8(p, 0); // target STI
+    *p++ = static_cast<uint8_t>(pduType);
+    WriteOctet4(p, pduLength);
+
+    p = pdu.append(4 + payloadLength);
+    p = WriteOctet4(p, static_cast<uint32_t>(payloadLength));
+    if (payloadLength > 0)
+        std::memcpy(p, payload.data(), payloadLength);
+}
+
+uint64_t PeekTargetSti(const uint8_t *buffer, size_t length)
+{
+    if (length < RLS_HEADER_LENGTH || buffer[0] != 3)
+        return 0;
+
+    uint64_t sti = 0;
+    for (size_t i = RLS_HEADER_LENGTH - 8; i < RLS_HEADER_LENGTH; i++)
+        sti = (sti << 8) | buffer[i];
+    return sti;
+}
+
+bool PatchCellInfoResponse(OctetString &stream, uint64_t targetSti, int dbm)
+{
+    if (stream.length() < RLS_CELL_INFO_DBM_OFFSET + 4 ||
+        stream.getI(4) != static_cast<int>(EMessageType::CELL_INFO_RESPONSE))
+        return false;
+
+    uint8_t *buffer = stream.data();
+    for (int i = RLS_HEADER_LENGTH - 1; i >= RLS_HEADER_LENGTH - 8; i--)
+    {
+        buffer[i] = static_cast<uint8_t>(targetSti & 0xFF);
+        targetSti >>= 8;
+    }
+
+    auto value = static_cast<uint32_t>(dbm);
+    for (int i = RLS_CELL_INFO_DBM_OFFSET + 3; i >= RLS_CELL_INFO_DBM_OFFSET; i--)
+    {
+        buffer[i] = static_cast<uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+    return true;
+}
+
 std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
 {
     auto first = stream.readI(); // (Just for old RLS compatibility)
@@ -96,10 +178,12 @@ std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
 
     auto msgType = static_cast<EMessageType>(stream.readI());
     uint64_t sti = stream.read8UL();
+    uint64_t targetSti = stream.read8UL();
 
     if (msgType == EMessageType::CELL_INFO_REQUEST)
     {
         auto res = std::make_unique<RlsCellInfoRequest>(sti);
+        res->targetSti = targetSti;
         res->simPos.x = stream.read4I();
         res->simPos.y = stream.read4I();
         res->simPos.z = stream.read4I();
@@ -108,6 +192,7 @@ std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
     else if (msgType == EMessageType::CELL_INFO_RESPONSE)
     {
         auto res = std::make_unique<RlsCellInfoResponse>(sti);
+        res->targetSti = targetSti;
         res->cellId = DecodeGlobalNci(stream);
         res->tac = stream.read4I();
         res->dbm = stream.read4I();
@@ -118,6 +203,7 @@ std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
     else if (msgType == EMessageType::PDU_DELIVERY)
     {
         auto res = std::make_unique<RlsPduDelivery>(sti);
+        res->targetSti = targetSti;
         res->pduType = static_cast<EPduType>(stream.readI());
         res->pdu = stream.readOctetString(stream.read4I());
         res->payload = stream.readOctetString(stream.read4I());
@@ -14,10 +14,20 @@
 #include <utils/common_types.hpp>
 #include <utils/octet_string.hpp>
 #include <utils/octet_view.hpp>
+#include <utils/packet_buffer.hpp>
 
 namespace rls
 {
 
+// A UE listening to the cell info beacons of the gNBs sends a cell info request only this often, so that the gNBs keep
+// it in coverage. A beaconing gNB considers such a UE lost after missing a few of them.
+static constexpr const int BEACON_KEEPALIVE_PERIOD = 10000;
+
+// Space around a data PDU to encode its PDU delivery in place, i.e. the header, the PDU type and the PDU length
+// before it, and the length and the PSI payload after it
+static constexpr const size_t PDU_DELIVERY_HEADROOM = 1 + 3 + 1 + 8 + 8 + 1 + 4;
+static constexpr const size_t PDU_DELIVERY_TAILROOM = 4 + 4;
+
 enum class EMessageType : uint8_t
 {
     RESERVED = 0,
@@ -37,6 +47,8 @@ struct RlsMessage
 {
     const EMessageType msgType;
     const uint64_t sti{};
+    // STI of the receiving UE in the messages sent by the gNB, used to demultiplex UEs sharing a socket
+    uint64_t targetSti{};
 
     explicit RlsMessage(EMessageType msgType, uint64_t sti) : msgType(msgType), sti(sti)
     {
@@ -77,6 +89,14 @@ struct RlsPduDelivery : RlsMessage
 };
 
 void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream);
+// Encodes a PDU delivery around the PDU in the buffer. The PDU is not copied if the buffer has enough headroom and
+// tailroom, see PDU_DELIVERY_HEADROOM and PDU_DELIVERY_TAILROOM.
+void EncodeRlsPduDelivery(uint64_t sti, EPduType pduType, const OctetString &payload, PacketBuffer &pdu);
 std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream);
+// Returns the target STI of an encoded message without decoding it, or 0 if the message is malformed.
+uint64_t PeekTargetSti(const uint8_t *buffer, size_t length);
+// Overwrites the target STI and the signal strength of an encoded cell info response, so that a message encoded once
+// is sent to many UEs. Returns false if the message is not a cell info response.
+bool PatchCellInfoResponse(OctetString &stream, uint64_t targetSti, int dbm);
 
 } // namespace rls
\ No newline at end of file
@@ -0,0 +1,195 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <utils/libc_error.hpp>
+#include <utils/nts.hpp>
+
+#define BUFFER_SIZE 65536
+#define MAX_EVENTS 64
+#define MAX_SHARED_THREADS 4
+#define ERROR_BACKOFF 100
+
+namespace udp
+{
+
+UdpReactor::UdpReactor(int threadCount) : m_logger{LogBase::Shared()->makeUniqueLogger("udp")}
+{
+    threadCount = std::max(threadCount, 1);
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        auto shard = std::make_unique<Shard>();
+        shard->buffer.resize(BUFFER_SIZE);
+
+        shard->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (shard->epollFd < 0)
+            throw LibError("epoll_create1 failed: ", errno);
+
+        shard->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shard->wakeFd < 0)
+            throw LibError("eventfd failed: ", errno);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, shard->wakeFd, &ev) != 0)
+            throw LibError("epoll_ctl failed: ", errno);
+
+        m_shards.push_back(std::move(shard));
+    }
+
+    for (auto &shard : m_shards)
+    {
+        Shard *s = shard.get();
+        s->thread = std::thread{[this, s]() { shardLoop(*s); }};
+    }
+}
+
+UdpReactor::~UdpReactor()
+{
+    m_isQuiting = true;
+
+    for (auto &shard : m_shards)
+    {
+        uint64_t one = 1;
+        ssize_t rc = ::write(shard->wakeFd, &one, sizeof(one));
+        (void)rc;
+    }
+
+    for (auto &shard : m_shards)
+    {
+        if (shard->thread.joinable())
+            shard->thread.join();
+        for (auto *reg : shard->retired)
+            delete reg;
+        ::close(shard->wakeFd);
+        ::close(shard->epollFd);
+    }
+}
+
+UdpReactor::Registration *UdpReactor::add(int fd, IUdpReactorHandler *handler)
+{
+    auto &shard = *m_shards[m_nextShard++ % m_shards.size()];
+
+    auto *reg = new Registration();
+    reg->shard = &shard;
+    reg->fd = fd;
+    reg->handler = handler;
+    reg->isActive = true;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = reg;
+    if (epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        int err = errno;
+        delete reg;
+        throw LibError("epoll_ctl failed: ", err);
+    }
+
+    return reg;
+}
+
+void UdpReactor::remove(Registration *reg)
+{
+    Shard &shard = *reg->shard;
+
+    epoll_ctl(shard.epollFd, EPOLL_CTL_DEL, reg->fd, nullptr);
+
+    // The registration may still be referenced by the events already returned to the reactor thread, hence it is
+    // released by the reactor thread before its next wait.
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    reg->isActive = false;
+    shard.dispatchCv.wait(lock, [&shard, reg]() { return shard.dispatching != reg; });
+    shard.retired.push_back(reg);
+}
+
+void UdpReactor::shardLoop(Shard &shard)
+{
+    epoll_event events[MAX_EVENTS];
+
+    // A slow task must not stall the other sockets of the shard
+    NtsTask::MarkNonBlockingThread();
+
+    while (!m_isQuiting)
+    {
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            for (auto *reg : shard.retired)
+                delete reg;
+            shard.retired.clear();
+        }
+
+        int n = epoll_wait(shard.epollFd, events, MAX_EVENTS, -1);
+        if (n < 0)
+        {
+            // Throwing here would terminate the whole process, hence the wait is retried after a while
+            int err = errno;
+            if (err != EINTR)
+            {
+                m_logger->err("epoll_wait failed: %s", std::strerror(err));
+                std::this_thread::sleep_for(std::chrono::milliseconds(ERROR_BACKOFF));
+            }
+            continue;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            auto *reg = reinterpret_cast<Registration *>(events[i].data.ptr);
+            if (reg == nullptr)
+            {
+                uint64_t value;
+                ssize_t rc = ::read(shard.wakeFd, &value, sizeof(value));
+                (void)rc;
+                continue;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                if (!reg->isActive)
+                    continue;
+                shard.dispatching = reg;
+            }
+
+            try
+            {
+                reg->handler->onReadable(shard.buffer.data(), shard.buffer.size());
+            }
+            catch (const std::exception &e)
+            {
+                m_logger->err("UDP receive failure: %s", e.what());
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                shard.dispatching = nullptr;
+            }
+            shard.dispatchCv.notify_all();
+        }
+    }
+}
+
+UdpReactor &UdpReactor::Shared()
+{
+    // Never destroyed, since the sockets may be removed by the other threads during exit.
+    static auto *reactor =
+        new UdpReactor(std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 4, 1, MAX_SHARED_THREADS));
+    return *reactor;
+}
+
+} // namespace udp
@@ -0,0 +1,89 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <utils/logger.hpp>
+
+namespace udp
+{
+
+class IUdpReactorHandler
+{
+  public:
+    virtual ~IUdpReactorHandler() = default;
+
+    // Called by a reactor thread when the registered socket is readable. The buffer is owned by the reactor thread
+    // and may be used as the receive buffer.
+    virtual void onReadable(uint8_t *buffer, size_t bufferSize) = 0;
+};
+
+// Waits for the readiness of the registered sockets with epoll and dispatches it to their handlers.
+// - Sockets are distributed over a few reactor threads, each having its own epoll instance.
+// - Handlers are called by a single thread at a time.
+// - Failures of epoll_wait and of the handlers are logged, and the reactor threads keep running.
+class UdpReactor
+{
+  private:
+    struct Shard;
+
+  public:
+    struct Registration
+    {
+        Shard *shard{};
+        int fd{};
+        IUdpReactorHandler *handler{};
+        bool isActive{};
+    };
+
+  private:
+    struct Shard
+    {
+        int epollFd{};
+        int wakeFd{};
+        std::thread thread{};
+
+        std::mutex mutex{};
+        std::condition_variable dispatchCv{};
+        Registration *dispatching{};
+        std::vector<Registration *> retired{};
+        std::vector<uint8_t> buffer{};
+    };
+
+    std::unique_ptr<Logger> m_logger;
+    std::vector<std::unique_ptr<Shard>> m_shards{};
+    std::atomic_size_t m_nextShard{};
+    std::atomic_bool m_isQuiting{};
+
+  public:
+    explicit UdpReactor(int threadCount);
+    ~UdpReactor();
+
+    UdpReactor(const UdpReactor &) = delete;
+    UdpReactor &operator=(const UdpReactor &) = delete;
+
+    Registration *add(int fd, IUdpReactorHandler *handler);
+    // - Once returned, the handler is not called anymore and can be destroyed.
+    // - Must not be called from the handler itself.
+    void remove(Registration *reg);
+
+    static UdpReactor &Shared();
+
+  private:
+    void shardLoop(Shard &shard);
+};
+
+} // namespace udp
@@ -8,17 +8,89 @@
 
 #include "server.hpp"
 
+#include <cerrno>
 #include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <utils/libc_error.hpp>
+
+// Fits the jumbo frames, the larger datagrams are truncated and dropped. Limits the receive buffer of a socket to 2.25
+// MiB together with cons::MaxUdpBatchSize.
+#define RECEIVE_SLOT_SIZE 9216
+// Initial capacity of the send queue for each datagram, it grows for the larger ones
+#define SEND_SLOT_SIZE 2048
+// Maximum time in milliseconds Flush() waits for the socket buffer to drain
+#define SEND_WAIT_TIMEOUT 10
 
 namespace udp
 {
 
-UdpServer::UdpServer() : socket{Socket::CreateUdp4()}
+// Returns true if the socket became writable in time, or the wait was interrupted
+static bool WaitWritable(int fd)
+{
+    pollfd pfd{};
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+
+    int rc = poll(&pfd, 1, SEND_WAIT_TIMEOUT);
+    if (rc < 0)
+        return errno == EINTR;
+    return rc > 0;
+}
+
+struct UdpServer::Batch
+{
+    struct Queued
+    {
+        InetAddress address;
+        size_t offset;
+        size_t length;
+    };
+
+    int size;
+
+    // Allocated without initialization, so that only the parts of the slots actually used are backed by memory
+    std::unique_ptr<uint8_t[]> receiveBuffer;
+    std::vector<mmsghdr> receiveHeaders;
+    std::vector<iovec> receiveIovs;
+    std::vector<sockaddr_storage> receiveAddresses;
+
+    std::vector<uint8_t> sendBuffer;
+    std::vector<Queued> sendQueue;
+    std::vector<mmsghdr> sendHeaders;
+    std::vector<iovec> sendIovs;
+
+    explicit Batch(int size)
+        : size{size}, receiveBuffer{new uint8_t[static_cast<size_t>(size) * RECEIVE_SLOT_SIZE]},
+          receiveHeaders(size), receiveIovs(size), receiveAddresses(size), sendBuffer{}, sendQueue{},
+          sendHeaders(size), sendIovs(size)
+    {
+        sendBuffer.reserve(static_cast<size_t>(size) * SEND_SLOT_SIZE);
+        sendQueue.reserve(size);
+
+        for (int i = 0; i < size; i++)
+        {
+            receiveIovs[i].iov_base = receiveBuffer.get() + static_cast<size_t>(i) * RECEIVE_SLOT_SIZE;
+            receiveIovs[i].iov_len = RECEIVE_SLOT_SIZE;
+        }
+    }
+};
+
+UdpServer::UdpServer(int batchSize) : socket{Socket::CreateUdp4()}, batch{}, counters{}
 {
+    if (batchSize > 1)
+        batch = std::make_unique<Batch>(batchSize);
 }
 
-UdpServer::UdpServer(const std::string &address, uint16_t port) : socket{Socket::CreateAndBindUdp({address, port})}
+UdpServer::UdpServer(const std::string &address, uint16_t port, int batchSize, UdpServerCounters *counters)
+    : socket{Socket::CreateAndBindUdp({address, port})}, batch{}, counters{counters}
 {
+    if (batchSize > 1)
+        batch = std::make_unique<Batch>(batchSize);
 }
 
 int UdpServer::Receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) const
@@ -26,14 +98,164 @@ int UdpServer::Receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAd
     return socket.receive(buffer, bufferSize, timeoutMs, outPeerAddress);
 }
 
+int UdpServer::ReceiveNonBlocking(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress) const
+{
+    return socket.receiveNonBlocking(buffer, bufferSize, outPeerAddress);
+}
+
+int UdpServer::Fd() const
+{
+    return socket.getFd();
+}
+
 void UdpServer::Send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) const
 {
     socket.send(address, buffer, bufferSize);
 }
 
+int UdpServer::BatchSize() const
+{
+    return batch != nullptr ? batch->size : 1;
+}
+
+int UdpServer::ReceiveBatch()
+{
+    if (batch == nullptr)
+        throw std::runtime_error("UDP server is not batched");
+
+    auto &b = *batch;
+    for (int i = 0; i < b.size; i++)
+    {
+        auto &hdr = b.receiveHeaders[i].msg_hdr;
+        std::memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = &b.receiveAddresses[i];
+        hdr.msg_namelen = sizeof(sockaddr_storage);
+        hdr.msg_iov = &b.receiveIovs[i];
+        hdr.msg_iovlen = 1;
+    }
+
+    while (true)
+    {
+        int rc = recvmmsg(socket.getFd(), b.receiveHeaders.data(), static_cast<unsigned>(b.size), MSG_DONTWAIT,
+                          nullptr);
+        if (rc >= 0)
+        {
+            for (int i = 0; i < rc; i++)
+            {
+                if ((b.receiveHeaders[i].msg_hdr.msg_flags & MSG_TRUNC) != 0)
+                {
+                    b.receiveHeaders[i].msg_len = 0;
+                    if (counters != nullptr)
+                        counters->receiveTruncated.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            return rc;
+        }
+
+        int err = errno;
+        if (err == EINTR)
+            continue;
+        if (err == EAGAIN || err == EWOULDBLOCK)
+            return 0;
+        throw LibError("recvmmsg failed: ", err);
+    }
+}
+
+const uint8_t *UdpServer::Received(int index, size_t &outLength, InetAddress &outPeerAddress) const
+{
+    auto &b = *batch;
+    outLength = b.receiveHeaders[index].msg_len;
+    outPeerAddress = InetAddress{b.receiveAddresses[index], b.receiveHeaders[index].msg_hdr.msg_namelen};
+    return reinterpret_cast<const uint8_t *>(b.receiveIovs[index].iov_base);
+}
+
+void UdpServer::Enqueue(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    if (batch == nullptr)
+    {
+        socket.send(address, buffer, bufferSize);
+        return;
+    }
+
+    auto &b = *batch;
+    size_t offset = b.sendBuffer.size();
+    b.sendBuffer.insert(b.sendBuffer.end(), buffer, buffer + bufferSize);
+    b.sendQueue.push_back({address, offset, bufferSize});
+
+    if (static_cast<int>(b.sendQueue.size()) >= b.size)
+        Flush();
+}
+
+void UdpServer::Flush()
+{
+    if (batch == nullptr)
+        return;
+
+    auto &b = *batch;
+    int count = static_cast<int>(b.sendQueue.size());
+    if (count == 0)
+        return;
+
+    // The iovecs are set up here, since the send buffer may be reallocated while the datagrams are queued
+    for (int i = 0; i < count; i++)
+    {
+        auto &queued = b.sendQueue[i];
+        b.sendIovs[i].iov_base = b.sendBuffer.data() + queued.offset;
+        b.sendIovs[i].iov_len = queued.length;
+
+        auto &hdr = b.sendHeaders[i].msg_hdr;
+        std::memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = const_cast<sockaddr *>(queued.address.getSockAddr());
+        hdr.msg_namelen = queued.address.getSockLen();
+        hdr.msg_iov = &b.sendIovs[i];
+        hdr.msg_iovlen = 1;
+    }
+
+    int sent = 0;
+    int error = 0;
+    bool waited = false;
+    while (sent < count)
+    {
+        int rc = sendmmsg(socket.getFd(), b.sendHeaders.data() + sent, static_cast<unsigned>(count - sent),
+                          MSG_DONTWAIT);
+        if (rc > 0)
+        {
+            sent += rc;
+            waited = false;
+            continue;
+        }
+
+        int err = errno;
+        if (rc < 0 && err == EINTR)
+            continue;
+        if (rc < 0 && (err == EAGAIN || err == EWOULDBLOCK))
+        {
+            // Waits at most once without progress, so that a congested socket does not block the task for long
+            if (!waited && WaitWritable(socket.getFd()))
+            {
+                waited = true;
+                continue;
+            }
+            if (counters != nullptr)
+                counters->sendDropped.fetch_add(static_cast<uint64_t>(count - sent), std::memory_order_relaxed);
+            break;
+        }
+
+        // The failing datagram is skipped, so that the datagrams to the other peers are still sent
+        error = rc < 0 ? err : EIO;
+        sent++;
+    }
+
+    b.sendQueue.clear();
+    b.sendBuffer.clear();
+
+    if (error != 0)
+        throw LibError("sendmmsg failed: ", error);
+}
+
 UdpServer::~UdpServer()
 {
     socket.close();
 }
 
-} // namespace udp
\ No newline at end of file
+} // namespace udp
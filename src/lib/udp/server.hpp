@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include <utils/network.hpp>
@@ -15,18 +18,51 @@
 namespace udp
 {
 
+// Counters of the batched I/O of a UdpServer. Owned by the user of the server, so that they can be read by any thread
+// regardless of the lifetime of the socket.
+struct UdpServerCounters
+{
+    // Queued datagrams dropped by Flush() since the socket buffer did not drain in time
+    std::atomic<uint64_t> sendDropped{};
+    // Received datagrams dropped by ReceiveBatch() since they did not fit into a receive slot
+    std::atomic<uint64_t> receiveTruncated{};
+};
+
 class UdpServer
 {
   private:
+    struct Batch;
+
     Socket socket;
+    std::unique_ptr<Batch> batch;
+    UdpServerCounters *counters;
 
   public:
-    UdpServer();
-    UdpServer(const std::string &address, uint16_t port);
+    // Up to batchSize datagrams are received or sent with a single system call, see ReceiveBatch() and Enqueue(). The
+    // buffers of the batched I/O are only allocated if the batch size is greater than 1. The counters are optional, and
+    // must outlive the server.
+    explicit UdpServer(int batchSize = 1);
+    UdpServer(const std::string &address, uint16_t port, int batchSize = 1, UdpServerCounters *counters = nullptr);
     ~UdpServer();
 
     int Receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) const;
+    int ReceiveNonBlocking(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress) const;
     void Send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) const;
+    [[nodiscard]] int Fd() const;
+
+    /* Batched I/O, the methods below must be called by a single thread at a time */
+
+    [[nodiscard]] int BatchSize() const;
+    // Receives the pending datagrams up to the batch size with recvmmsg without blocking, returns their number. The
+    // datagrams are accessed with Received() until the next call, the truncated ones have a length of zero. The batch
+    // size must be greater than 1.
+    int ReceiveBatch();
+    const uint8_t *Received(int index, size_t &outLength, InetAddress &outPeerAddress) const;
+    // Copies the datagram into the send queue, the queue is flushed once it is full. Sent at once if not batched.
+    void Enqueue(const InetAddress &address, const uint8_t *buffer, size_t bufferSize);
+    // Sends the queued datagrams with sendmmsg. If the socket buffer is full, waits shortly for it to drain, and the
+    // datagrams still not fitting into it are dropped and counted.
+    void Flush();
 };
 
 } // namespace udp
@@ -8,49 +8,106 @@
 
 #include "server_task.hpp"
 
-#include <cstring>
+// Limits the datagrams received at once, so that the other sockets of the reactor thread are not starved
+#define RECEIVE_BUDGET 64
 
-#define BUFFER_SIZE 65536
-#define TIMEOUT_MS 500
-
-udp::UdpServerTask::UdpServerTask(NtsTask *targetTask) : server{}, targetTask(targetTask)
+udp::UdpServerTask::UdpServerTask(NtsTask *targetTask, NtsLane lane)
+    : server{}, targetTask(targetTask), lane(lane), registration{}
 {
     server = new UdpServer();
 }
 
-udp::UdpServerTask::UdpServerTask(const std::string &address, uint16_t port, NtsTask *targetTask)
-    : server{}, targetTask(targetTask)
+udp::UdpServerTask::UdpServerTask(const std::string &address, uint16_t port, NtsTask *targetTask, NtsLane lane,
+                                  int batchSize, UdpServerCounters *counters)
+    : server{}, targetTask(targetTask), lane(lane), registration{}
 {
-    server = new UdpServer(address, port);
+    server = new UdpServer(address, port, batchSize, counters);
 }
 
-udp::UdpServerTask::~UdpServerTask() = default;
+udp::UdpServerTask::~UdpServerTask()
+{
+    quit();
+}
 
-void udp::UdpServerTask::onStart()
+void udp::UdpServerTask::start()
 {
+    if (registration == nullptr && server != nullptr)
+        registration = UdpReactor::Shared().add(server->Fd(), this);
 }
 
-void udp::UdpServerTask::onLoop()
+void udp::UdpServerTask::quit()
 {
-    uint8_t buffer[BUFFER_SIZE];
+    if (registration != nullptr)
+    {
+        UdpReactor::Shared().remove(registration);
+        registration = nullptr;
+    }
+
+    delete server;
+    server = nullptr;
+}
 
-    InetAddress peerAddress{};
+void udp::UdpServerTask::onReadable(uint8_t *buffer, size_t bufferSize)
+{
+    if (server->BatchSize() > 1)
+    {
+        receiveBatches();
+        return;
+    }
 
-    int size = server->Receive(buffer, BUFFER_SIZE, TIMEOUT_MS, peerAddress);
-    if (size > 0)
+    for (int i = 0; i < RECEIVE_BUDGET; i++)
     {
-        std::vector<uint8_t> v(size);
-        std::memcpy(v.data(), buffer, size);
-        targetTask->push(new NwUdpServerReceive(OctetString{std::move(v)}, peerAddress));
+        InetAddress peerAddress{};
+
+        int size = server->ReceiveNonBlocking(buffer, bufferSize, peerAddress);
+        if (size <= 0)
+            break;
+
+        std::vector<uint8_t> v(buffer, buffer + size);
+        targetTask->push(new NwUdpServerReceive(OctetString{std::move(v)}, peerAddress), lane);
     }
 }
 
-void udp::UdpServerTask::onQuit()
+void udp::UdpServerTask::receiveBatches()
 {
-    delete server;
+    int received = 0;
+    while (received < RECEIVE_BUDGET)
+    {
+        int count = server->ReceiveBatch();
+        for (int i = 0; i < count; i++)
+        {
+            InetAddress peerAddress{};
+            size_t size = 0;
+            const uint8_t *data = server->Received(i, size, peerAddress);
+            if (size == 0)
+                continue;
+
+            std::vector<uint8_t> v(data, data + size);
+            targetTask->push(new NwUdpServerReceive(OctetString{std::move(v)}, peerAddress), lane);
+        }
+
+        received += count;
+        if (count < server->BatchSize())
+            break;
+    }
 }
 
 void udp::UdpServerTask::send(const InetAddress &to, const OctetString &packet)
 {
     server->Send(to, packet.data(), static_cast<size_t>(packet.length()));
 }
+
+void udp::UdpServerTask::send(const InetAddress &to, const uint8_t *buffer, size_t length)
+{
+    server->Send(to, buffer, length);
+}
+
+void udp::UdpServerTask::enqueue(const InetAddress &to, const OctetString &packet)
+{
+    server->Enqueue(to, packet.data(), static_cast<size_t>(packet.length()));
+}
+
+void udp::UdpServerTask::flush()
+{
+    server->Flush();
+}
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <lib/udp/reactor.hpp>
 #include <lib/udp/server.hpp>
 #include <utils/nts.hpp>
 #include <utils/octet_string.hpp>
@@ -15,35 +16,52 @@
 namespace udp
 {
 
-struct NwUdpServerReceive : NtsMessage
+struct NwUdpServerReceive final : NtsPooledMessage<NwUdpServerReceive, NtsMessageType::UDP_SERVER_RECEIVE>
 {
     OctetString packet;
     InetAddress fromAddress;
 
     explicit NwUdpServerReceive(OctetString &&packet, const InetAddress &fromAddress)
-        : NtsMessage(NtsMessageType::UDP_SERVER_RECEIVE), packet(std::move(packet)), fromAddress(fromAddress)
+        : packet(std::move(packet)), fromAddress(fromAddress)
     {
     }
 };
 
-class UdpServerTask : public NtsTask
+// Delivers the datagrams received by a UDP socket to the target task.
+// - Does not own a thread, the socket is watched by the shared UdpReactor between start() and quit().
+// - With a batch size greater than 1, the datagrams are received with recvmmsg, and the ones given to enqueue() are
+//   sent with sendmmsg once the batch is full or flush() is called. The target task is expected to call flush() when
+//   it runs out of messages.
+class UdpServerTask : public IUdpReactorHandler
 {
   private:
     UdpServer *server;
     NtsTask *targetTask;
+    NtsLane lane;
+    UdpReactor::Registration *registration;
 
   public:
-    explicit UdpServerTask(NtsTask *targetTask);
-    UdpServerTask(const std::string &address, uint16_t port, NtsTask *targetTask);
+    explicit UdpServerTask(NtsTask *targetTask, NtsLane lane = NtsLane::CONTROL);
+    UdpServerTask(const std::string &address, uint16_t port, NtsTask *targetTask, NtsLane lane = NtsLane::CONTROL,
+                  int batchSize = 1, UdpServerCounters *counters = nullptr);
     ~UdpServerTask() override;
 
+    void start();
+    void quit();
+
   protected:
-    void onStart() override;
-    void onLoop() override;
-    void onQuit() override;
+    void onReadable(uint8_t *buffer, size_t bufferSize) override;
+
+  private:
+    void receiveBatches();
 
   public:
     void send(const InetAddress &to, const OctetString &packet);
+    void send(const InetAddress &to, const uint8_t *buffer, size_t length);
+
+    // Must be called by a single thread, i.e. the target task
+    void enqueue(const InetAddress &to, const OctetString &packet);
+    void flush();
 };
 
 } // namespace udp
@@ -0,0 +1,173 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+// Measures the message throughput from a number of producer threads to a single consumer, for the NtsTask mailbox and
+// for a reference deque+mutex mailbox as used by NtsTask before the lock-free mailbox.
+//
+// Usage: nr-mailbox-bench [producers] [messages-per-producer]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <utils/nts.hpp>
+
+#define DEFAULT_PRODUCERS 4
+#define DEFAULT_MESSAGES 1000000
+#define WAIT_TIME 500
+
+struct BenchMessage : NtsMessage
+{
+    BenchMessage() : NtsMessage(NtsMessageType::UNDEFINED)
+    {
+    }
+};
+
+// Consumes the messages with the NtsTask mailbox
+class NtsConsumer : public NtsTask
+{
+  public:
+    std::atomic<int64_t> consumed{};
+
+  protected:
+    void onStart() override
+    {
+    }
+
+    void onLoop() override
+    {
+        NtsMessage *msg = take();
+        if (msg == nullptr)
+            return;
+        delete msg;
+        consumed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onQuit() override
+    {
+    }
+};
+
+// Consumes the messages with the deque+mutex+condition variable mailbox
+class DequeConsumer
+{
+  private:
+    std::deque<NtsMessage *> m_queue{};
+    std::mutex m_mutex{};
+    std::condition_variable m_cv{};
+    std::atomic<bool> m_isQuiting{};
+    std::thread m_thread{};
+
+  public:
+    std::atomic<int64_t> consumed{};
+
+    void start()
+    {
+        m_thread = std::thread{[this]() {
+            while (!m_isQuiting)
+            {
+                NtsMessage *msg = take();
+                if (msg == nullptr)
+                    continue;
+                delete msg;
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }};
+    }
+
+    void quit()
+    {
+        m_isQuiting = true;
+        m_cv.notify_one();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    void push(NtsMessage *msg)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queue.push_back(msg);
+        }
+        m_cv.notify_one();
+    }
+
+  private:
+    NtsMessage *take()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queue.empty())
+            m_cv.wait_for(lock, std::chrono::milliseconds(WAIT_TIME));
+        if (m_queue.empty())
+            return nullptr;
+        NtsMessage *msg = m_queue.front();
+        m_queue.pop_front();
+        return msg;
+    }
+};
+
+// Returns the throughput in million messages per second
+template <typename Consumer>
+static double Run(Consumer &consumer, int producers, int64_t messages)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < producers; i++)
+    {
+        threads.emplace_back([&consumer, messages]() {
+            for (int64_t j = 0; j < messages; j++)
+                consumer.push(new BenchMessage());
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    int64_t total = messages * producers;
+    while (consumer.consumed.load(std::memory_order_relaxed) < total)
+        std::this_thread::yield();
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return static_cast<double>(total) / elapsed / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int producers = argc > 1 ? std::atoi(argv[1]) : DEFAULT_PRODUCERS;
+    int64_t messages = argc > 2 ? std::atoll(argv[2]) : DEFAULT_MESSAGES;
+    if (producers <= 0 || messages <= 0)
+    {
+        std::fprintf(stderr, "Usage: nr-mailbox-bench [producers] [messages-per-producer]\n");
+        return 2;
+    }
+
+    double deque, mailbox;
+    {
+        DequeConsumer consumer{};
+        consumer.start();
+        deque = Run(consumer, producers, messages);
+        consumer.quit();
+    }
+    {
+        NtsConsumer consumer{};
+        consumer.start();
+        mailbox = Run(consumer, producers, messages);
+        consumer.quit();
+    }
+
+    std::printf("producers: %d, messages: %lld\n", producers, static_cast<long long>(messages * producers));
+    std::printf("deque+mutex: %.2f Mmsg/s\n", deque);
+    std::printf("nts mailbox: %.2f Mmsg/s\n", mailbox);
+    return 0;
+}
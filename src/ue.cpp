@@ -6,7 +6,9 @@
 // and subject to the terms and conditions defined in LICENSE file.
 //
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 #include <unistd.h>
@@ -14,20 +16,35 @@
 #include <lib/app/base_app.hpp>
 #include <lib/app/cli_base.hpp>
 #include <lib/app/cli_cmd.hpp>
+#include <lib/app/launch.hpp>
+#include <lib/app/logging.hpp>
 #include <lib/app/proc_table.hpp>
+#include <lib/app/queue_config.hpp>
 #include <lib/app/ue_ctl.hpp>
+#include <lib/app/workers.hpp>
+#include <ue/hibernation.hpp>
+#include <ue/rls/demux.hpp>
+#include <ue/subscribers.hpp>
+#include <ue/tun/shared.hpp>
 #include <ue/ue.hpp>
 #include <utils/common.hpp>
 #include <utils/concurrent_map.hpp>
 #include <utils/constants.hpp>
+#include <utils/memory.hpp>
 #include <utils/options.hpp>
 #include <utils/yaml_utils.hpp>
 #include <yaml-cpp/yaml.h>
 
 static app::CliServer *g_cliServer = nullptr;
-static nr::ue::UeConfig *g_refConfig = nullptr;
-static ConcurrentMap<std::string, nr::ue::UserEquipment *> g_ueMap{};
+static nr::ue::UeBaseConfig *g_refConfig = nullptr;
+static ConcurrentMap<std::string, nr::ue::UserEquipment *> g_ueMap{}; // by node name
+static ConcurrentMap<int, nr::ue::UserEquipment *> g_ueIds{};          // by UE index
 static app::CliResponseTask *g_cliRespTask = nullptr;
+static NtsExecutor *g_executor = nullptr;
+static nr::ue::UeRlsDemux *g_rlsDemux = nullptr;
+static nr::ue::UeHibernator *g_hibernator = nullptr;
+static nr::ue::UeSharedTun *g_sharedTun = nullptr;
+static nr::ue::SubscriberTable *g_subscribers = nullptr;
 
 static struct Options
 {
@@ -36,17 +53,33 @@ static struct Options
     bool disableCmd{};
     std::string imsi{};
     int count{};
+    int threads{};
+    int rlsSockets{};
+    bool sharedTun{};
+    std::string launchProfile{};
+    std::string subscriberFile{};
+    std::string writeSubscribersFile{};
+    int64_t hibernateAfter{};
+    int workers{};
 } g_options{};
 
+static app::LaunchProfile g_launchProfile{};
+static app::WorkerPartition g_partition{};
+
 struct NwUeControllerCmd : NtsMessage
 {
     enum PR
     {
         PERFORM_SWITCH_OFF,
+        LAUNCH,
     } present;
 
     // PERFORM_SWITCH_OFF
     nr::ue::UserEquipment *ue{};
+    int ueIndex{};
+
+    // LAUNCH
+    std::vector<std::pair<int64_t, nr::ue::UserEquipment *>> launchList{};
 
     explicit NwUeControllerCmd(PR present) : NtsMessage(NtsMessageType::UE_CTL_COMMAND), present(present)
     {
@@ -55,6 +88,26 @@ struct NwUeControllerCmd : NtsMessage
 
 class UeControllerTask : public NtsTask
 {
+  private:
+    static constexpr const int LAUNCH_TIMER_ID = 1;
+
+    // Pending launches sorted by the launch time relative to m_launchStart
+    std::vector<std::pair<int64_t, nr::ue::UserEquipment *>> m_launchList{};
+    size_t m_launchIndex{};
+    int64_t m_launchStart{};
+
+    void launchDueUes()
+    {
+        int64_t elapsed = utils::MonotonicTimeMillis() - m_launchStart;
+        while (m_launchIndex < m_launchList.size() && m_launchList[m_launchIndex].first <= elapsed)
+            m_launchList[m_launchIndex++].second->start();
+
+        if (m_launchIndex < m_launchList.size())
+            setTimer(LAUNCH_TIMER_ID, m_launchList[m_launchIndex].first - elapsed);
+        else
+            m_launchList.clear();
+    }
+
   protected:
     void onStart() override
     {
@@ -65,25 +118,43 @@ class UeControllerTask : public NtsTask
         auto *msg = take();
         if (msg == nullptr)
             return;
+        if (msg->msgType == NtsMessageType::TIMER_EXPIRED)
+        {
+            if (dynamic_cast<NwTimerExpired *>(msg)->timerId == LAUNCH_TIMER_ID)
+                launchDueUes();
+            delete msg;
+            return;
+        }
         if (msg->msgType == NtsMessageType::UE_CTL_COMMAND)
         {
             auto *w = dynamic_cast<NwUeControllerCmd *>(msg);
             switch (w->present)
             {
             case NwUeControllerCmd::PERFORM_SWITCH_OFF: {
-                std::string key{};
-                g_ueMap.invokeForeach([&key, &w](auto &item) {
-                    if (item.second == w->ue)
-                        key = item.first;
-                });
-
-                if (key.empty())
-                    return;
-
-                if (g_ueMap.removeAndGetSize(key) == 0)
+                // The UE is not dereferenced until it is found in the registry, since a duplicate switch-off message
+                // refers to an already deleted UE
+                if (g_ueIds.getOrDefault(w->ueIndex) != w->ue)
+                {
+                    delete w;
+                    break;
+                }
+
+                g_ueIds.remove(w->ueIndex);
+                if (g_ueMap.removeAndGetSize(w->ue->getConfig().getNodeName()) == 0)
                     exit(0);
 
                 delete w->ue;
+                delete w;
+                break;
+            }
+            case NwUeControllerCmd::LAUNCH: {
+                m_launchList = std::move(w->launchList);
+                std::stable_sort(m_launchList.begin(), m_launchList.end(),
+                                 [](auto &a, auto &b) { return a.first < b.first; });
+                m_launchIndex = 0;
+                m_launchStart = utils::MonotonicTimeMillis();
+                launchDueUes();
+                delete w;
                 break;
             }
             }
@@ -97,9 +168,9 @@ class UeControllerTask : public NtsTask
 
 static UeControllerTask *g_controllerTask;
 
-static nr::ue::UeConfig *ReadConfigYaml()
+static nr::ue::UeBaseConfig *ReadConfigYaml()
 {
-    auto *result = new nr::ue::UeConfig();
+    auto *result = new nr::ue::UeBaseConfig();
     auto config = YAML::LoadFile(g_options.configFile);
 
     result->hplmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
@@ -140,9 +211,6 @@ static nr::ue::UeConfig *ReadConfigYaml()
 
     result->configureRouting = !g_options.noRoutingConfigs;
 
-    // If we have multiple UEs in the same process, then log names should be separated.
-    result->prefixLogger = g_options.count > 1;
-
     if (yaml::HasField(config, "supi"))
         result->supi = Supi::Parse(yaml::GetString(config, "supi"));
     if (yaml::HasField(config, "imei"))
@@ -217,6 +285,41 @@ static nr::ue::UeConfig *ReadConfigYaml()
         result->integrityMaxRate.downlinkFull = downlink == "full";
     }
 
+    result->tunQueues = 1;
+    if (yaml::HasField(config, "tunQueues"))
+        result->tunQueues = yaml::GetInt32(config, "tunQueues", 1, cons::MaxTunQueues);
+
+    auto queueConfig = app::ReadQueueConfig(config);
+    result->queueCapacity = queueConfig.capacity;
+    result->queuePolicy = queueConfig.policy;
+
+    result->passiveMeasurement = false;
+    if (yaml::HasField(config, "passiveMeasurement"))
+        result->passiveMeasurement = yaml::GetBool(config, "passiveMeasurement");
+
+    if (yaml::HasField(config, "launch"))
+    {
+        auto launch = config["launch"];
+        g_launchProfile.type = app::ParseLaunchProfileType(yaml::GetString(launch, "profile"));
+        if (yaml::HasField(launch, "rate"))
+            g_launchProfile.rate = launch["rate"].as<double>();
+        if (yaml::HasField(launch, "startRate"))
+            g_launchProfile.startRate = launch["startRate"].as<double>();
+        if (yaml::HasField(launch, "rampDuration"))
+            g_launchProfile.rampDuration = yaml::GetInt32(launch, "rampDuration", 0, std::nullopt);
+        if (yaml::HasField(launch, "burstSize"))
+            g_launchProfile.burstSize = yaml::GetInt32(launch, "burstSize", 0, std::nullopt);
+        if (yaml::HasField(launch, "burstInterval"))
+            g_launchProfile.burstInterval = yaml::GetInt32(launch, "burstInterval", 0, std::nullopt);
+        if (yaml::HasField(launch, "jitter"))
+            g_launchProfile.jitter = yaml::GetInt32(launch, "jitter", 0, std::nullopt);
+        if (yaml::HasField(launch, "seed"))
+            g_launchProfile.seed = static_cast<uint64_t>(yaml::GetInt64(launch, "seed", 0, std::nullopt));
+        app::ValidateLaunchProfile(g_launchProfile);
+    }
+
+    logging::Configure(app::ReadLogConfig(config));
+
     return result;
 }
 
@@ -234,28 +337,80 @@ static void ReadOptions(int argc, char **argv)
                                       std::nullopt};
     opt::OptionItem itemDisableRouting = {'r', "no-routing-config",
                                           "Do not auto configure routing for UE TUN interface", std::nullopt};
+    opt::OptionItem itemThreads = {'t', "threads", "Run the tasks of all UEs on a shared pool of specified size",
+                                   "num"};
+    opt::OptionItem itemSharedRls = {'s', "shared-rls", "Share specified number of RLS sockets among all UEs",
+                                     "num"};
+    opt::OptionItem itemSharedTun = {std::nullopt, "shared-tun",
+                                     "Use a single TUN interface for the PDU sessions of all UEs", std::nullopt};
+    opt::OptionItem itemLaunch = {'p', "launch-profile",
+                                  "Launch the UEs with specified arrival profile (immediate, constant, ramp, poisson, "
+                                  "burst), e.g. ramp:start-rate=1,rate=100,duration=60000,jitter=50",
+                                  "profile"};
+    opt::OptionItem itemSubscribers = {'u', "subscribers",
+                                       "Read SUPI, K, OPc, AMF, slices and sessions of each UE from specified CSV or "
+                                       "binary subscriber table",
+                                       "file"};
+    opt::OptionItem itemWriteSubscribers = {std::nullopt, "write-subscribers",
+                                            "Convert the subscriber table to the binary format in specified file and "
+                                            "exit",
+                                            "file"};
+    opt::OptionItem itemHibernate = {std::nullopt, "hibernate",
+                                     "Hibernate the UEs staying idle for specified milliseconds, which requires "
+                                     "shared RLS sockets",
+                                     "ms"};
+    opt::OptionItem itemWorkers = {'w', "workers",
+                                   "Distribute the UEs over specified number of worker processes, each one pinned to "
+                                   "a CPU",
+                                   "num"};
 
     desc.items.push_back(itemConfigFile);
     desc.items.push_back(itemImsi);
     desc.items.push_back(itemCount);
     desc.items.push_back(itemDisableCmd);
     desc.items.push_back(itemDisableRouting);
+    desc.items.push_back(itemThreads);
+    desc.items.push_back(itemSharedRls);
+    desc.items.push_back(itemSharedTun);
+    desc.items.push_back(itemLaunch);
+    desc.items.push_back(itemSubscribers);
+    desc.items.push_back(itemWriteSubscribers);
+    desc.items.push_back(itemHibernate);
+    desc.items.push_back(itemWorkers);
 
     opt::OptionsResult opt{argc, argv, desc, false, nullptr};
 
     g_options.configFile = opt.getOption(itemConfigFile);
     g_options.noRoutingConfigs = opt.hasFlag(itemDisableRouting);
+
+    g_options.threads = 0;
+    if (opt.hasFlag(itemThreads))
+    {
+        g_options.threads = utils::ParseInt(opt.getOption(itemThreads));
+        if (g_options.threads <= 0)
+            throw std::runtime_error("Invalid number of threads");
+    }
+
+    g_options.rlsSockets = 0;
+    if (opt.hasFlag(itemSharedRls))
+    {
+        g_options.rlsSockets = utils::ParseInt(opt.getOption(itemSharedRls));
+        if (g_options.rlsSockets <= 0)
+            throw std::runtime_error("Invalid number of RLS sockets");
+    }
+
+    g_options.sharedTun = opt.hasFlag(itemSharedTun);
+
     if (opt.hasFlag(itemCount))
     {
         g_options.count = utils::ParseInt(opt.getOption(itemCount));
         if (g_options.count <= 0)
             throw std::runtime_error("Invalid number of UEs");
-        if (g_options.count > 512)
-            throw std::runtime_error("Number of UEs is too big");
     }
     else
     {
-        g_options.count = 1;
+        // Resolved after the subscriber table is opened
+        g_options.count = 0;
     }
 
     g_options.imsi = {};
@@ -266,70 +421,90 @@ static void ReadOptions(int argc, char **argv)
     }
 
     g_options.disableCmd = opt.hasFlag(itemDisableCmd);
-}
 
-static std::string LargeSum(std::string a, std::string b)
-{
-    if (a.length() > b.length())
-        std::swap(a, b);
+    g_options.launchProfile = {};
+    if (opt.hasFlag(itemLaunch))
+        g_options.launchProfile = opt.getOption(itemLaunch);
+
+    g_options.subscriberFile = {};
+    if (opt.hasFlag(itemSubscribers))
+        g_options.subscriberFile = opt.getOption(itemSubscribers);
 
-    std::string str;
-    int n1 = a.length(), n2 = b.length();
+    g_options.writeSubscribersFile = {};
+    if (opt.hasFlag(itemWriteSubscribers))
+    {
+        if (g_options.subscriberFile.empty())
+            throw std::runtime_error("A subscriber table (--subscribers) is required for conversion");
+        g_options.writeSubscribersFile = opt.getOption(itemWriteSubscribers);
+    }
 
-    reverse(a.begin(), a.end());
-    reverse(b.begin(), b.end());
+    if (!g_options.subscriberFile.empty() && !g_options.imsi.empty())
+        throw std::runtime_error("IMSI cannot be specified together with a subscriber table");
 
-    int carry = 0;
-    for (int i = 0; i < n1; i++)
+    g_options.hibernateAfter = 0;
+    if (opt.hasFlag(itemHibernate))
     {
-        int sum = ((a[i] - '0') + (b[i] - '0') + carry);
-        str.push_back(sum % 10 + '0');
-        carry = sum / 10;
+        g_options.hibernateAfter = utils::ParseInt(opt.getOption(itemHibernate));
+        if (g_options.hibernateAfter <= 0)
+            throw std::runtime_error("Invalid hibernation delay");
+        // Hibernated UEs are kept reachable through the shared RLS sockets
+        if (g_options.rlsSockets == 0)
+            throw std::runtime_error("Hibernation requires shared RLS sockets (--shared-rls)");
     }
-    for (int i = n1; i < n2; i++)
+
+    // Checked against the number of UEs after it is resolved
+    g_options.workers = 1;
+    if (opt.hasFlag(itemWorkers))
     {
-        int sum = ((b[i] - '0') + carry);
-        str.push_back(sum % 10 + '0');
-        carry = sum / 10;
+        g_options.workers = utils::ParseInt(opt.getOption(itemWorkers));
+        if (g_options.workers <= 0)
+            throw std::runtime_error("Invalid number of worker processes");
     }
-    if (carry)
-        throw std::runtime_error("UE serial number overflow");
-    reverse(str.begin(), str.end());
-    return str;
 }
 
-static void IncrementNumber(std::string &s, int delta)
+// Opens the subscriber table and resolves the number of UEs
+static void PrepareSubscribers()
 {
-    s = LargeSum(s, std::to_string(delta));
+    if (!g_options.subscriberFile.empty())
+    {
+        g_subscribers = new nr::ue::SubscriberTable(g_options.subscriberFile);
+        g_refConfig->subscribers = g_subscribers;
+
+        if (!g_options.writeSubscribersFile.empty())
+        {
+            nr::ue::SubscriberTable::WriteBinary(*g_subscribers, g_options.writeSubscribersFile);
+            std::cout << "Subscriber table is written to " << g_options.writeSubscribersFile << std::endl;
+            exit(0);
+        }
+
+        // Without an explicit number of UEs, there is one UE for each row of the table
+        if (g_options.count == 0)
+        {
+            size_t rows = g_subscribers->size();
+            if (rows == 0 || rows > static_cast<size_t>(std::numeric_limits<int>::max()))
+                throw std::runtime_error("Invalid number of rows in the subscriber table");
+            g_options.count = static_cast<int>(rows);
+        }
+    }
+
+    if (g_options.count == 0)
+        g_options.count = 1;
+
+    if (g_options.workers > g_options.count)
+        throw std::runtime_error("Number of worker processes cannot exceed the number of UEs");
+
+    // Without a shared thread pool, every UE consumes several threads
+    int perProcess = (g_options.count + g_options.workers - 1) / g_options.workers;
+    if (perProcess > 512 && g_options.threads == 0)
+        throw std::runtime_error("Number of UEs is too big, consider using a thread pool (--threads)");
+
+    // If we have multiple UEs in the same process, then log names should be separated.
+    g_refConfig->prefixLogger = g_options.count > 1;
 }
 
 static nr::ue::UeConfig *GetConfigByUe(int ueIndex)
 {
-    auto *c = new nr::ue::UeConfig();
-    c->key = g_refConfig->key.copy();
-    c->opC = g_refConfig->opC.copy();
-    c->opType = g_refConfig->opType;
-    c->amf = g_refConfig->amf.copy();
-    c->imei = g_refConfig->imei;
-    c->imeiSv = g_refConfig->imeiSv;
-    c->supi = g_refConfig->supi;
-    c->hplmn = g_refConfig->hplmn;
-    c->initials = g_refConfig->initials;
-    c->supportedAlgs = g_refConfig->supportedAlgs;
-    c->gnbSearchList = g_refConfig->gnbSearchList;
-    c->initSessions = g_refConfig->initSessions;
-    c->configureRouting = g_refConfig->configureRouting;
-    c->prefixLogger = g_refConfig->prefixLogger;
-    c->integrityMaxRate = g_refConfig->integrityMaxRate;
-
-    if (c->supi.has_value())
-        IncrementNumber(c->supi->value, ueIndex);
-    if (c->imei.has_value())
-        IncrementNumber(*c->imei, ueIndex);
-    if (c->imeiSv.has_value())
-        IncrementNumber(*c->imeiSv, ueIndex);
-
-    return c;
+    return new nr::ue::UeConfig(g_refConfig, ueIndex);
 }
 
 static void ReceiveCommand(app::CliMessage &msg)
@@ -383,6 +558,27 @@ static void ReceiveCommand(app::CliMessage &msg)
     ue->pushCommand(std::move(cmd), msg.clientAddr);
 }
 
+// Reports the memory usage per UE, before the UEs are started
+static void ReportMemoryUsage(const std::vector<nr::ue::UserEquipment *> &ueList, size_t residentBefore)
+{
+    if (ueList.empty())
+        return;
+
+    nr::ue::UeMemoryUsage usage{};
+    for (auto *ue : ueList)
+        usage += ue->estimateMemoryUsage();
+
+    size_t count = ueList.size();
+    size_t residentAfter = utils::ResidentMemory();
+    size_t resident = residentAfter > residentBefore ? (residentAfter - residentBefore) / count : 0;
+
+    std::cout << "Memory usage per UE: " << resident << " bytes resident, " << usage.total() / count
+              << " bytes estimated (config " << usage.config / count << ", app " << usage.app / count << ", nas "
+              << usage.nas / count << ", rrc " << usage.rrc / count << ", rls " << usage.rls / count << ", loggers "
+              << usage.loggers / count << "), " << usage.threads / static_cast<int>(count) << " dedicated threads"
+              << std::endl;
+}
+
 static void Loop()
 {
     if (!g_cliServer)
@@ -423,6 +619,7 @@ static class UeController : public app::IUeController
     {
         auto *w = new NwUeControllerCmd(NwUeControllerCmd::PERFORM_SWITCH_OFF);
         w->ue = ue;
+        w->ueIndex = ue->getConfig().index;
         g_controllerTask->push(w);
     }
 } g_ueController;
@@ -435,8 +632,19 @@ int main(int argc, char **argv)
     {
         ReadOptions(argc, argv);
         g_refConfig = ReadConfigYaml();
+        if (!g_options.launchProfile.empty())
+            g_launchProfile = app::ParseLaunchProfile(g_options.launchProfile);
         if (g_options.imsi.length() > 0)
             g_refConfig->supi = Supi::Parse("imsi-" + g_options.imsi);
+        PrepareSubscribers();
+        g_refConfig->hibernateAfter = g_options.hibernateAfter;
+
+        // Identities of the last UE are the largest ones, check them for overflow before creating any UE.
+        // With a subscriber table, this also checks that the table has a row for every UE.
+        nr::ue::UeConfig lastUe{g_refConfig, g_options.count - 1};
+        (void)lastUe.getSupi();
+        (void)lastUe.getImei();
+        (void)lastUe.getImeiSv();
     }
     catch (const std::runtime_error &e)
     {
@@ -446,29 +654,124 @@ int main(int argc, char **argv)
 
     std::cout << cons::Name << std::endl;
 
+    // The workers are forked before any thread is created, each worker continues with its own part of the UEs
+    g_partition = {0, 0, g_options.count, -1};
+    if (g_options.workers > 1)
+    {
+        try
+        {
+            g_partition = app::RunCoordinator(g_options.workers, g_options.count, !g_options.disableCmd);
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     g_controllerTask = new UeControllerTask();
     g_controllerTask->start();
 
+    if (g_options.threads > 0)
+        g_executor = new NtsExecutor(g_options.threads);
+
+    if (g_options.rlsSockets > 0)
+        g_rlsDemux = new nr::ue::UeRlsDemux(g_options.rlsSockets);
+
+    if (g_options.hibernateAfter > 0)
+    {
+        g_hibernator = new nr::ue::UeHibernator(g_rlsDemux, g_refConfig->gnbSearchList,
+                                                 g_refConfig->passiveMeasurement);
+        g_hibernator->start();
+    }
+
+    if (g_options.sharedTun)
+    {
+        if (!utils::IsRoot())
+        {
+            std::cerr << "ERROR: Shared TUN interface requires root permissions" << std::endl;
+            return 1;
+        }
+        try
+        {
+            g_sharedTun = new nr::ue::UeSharedTun(g_refConfig->tunQueues, !g_options.noRoutingConfigs);
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "ERROR: Shared TUN interface could not be setup: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     if (!g_options.disableCmd)
     {
         g_cliServer = new app::CliServer{};
         g_cliRespTask = new app::CliResponseTask(g_cliServer);
     }
 
-    for (int i = 0; i < g_options.count; i++)
+    // The memory shared by the UEs is allocated before the baseline
+    logging::Start();
+    size_t residentBefore = utils::ResidentMemory();
+
+    std::vector<nr::ue::UserEquipment *> ueList{};
+    try
     {
-        auto *config = GetConfigByUe(i);
-        auto *ue = new nr::ue::UserEquipment(config, &g_ueController, nullptr, g_cliRespTask);
-        g_ueMap.put(config->getNodeName(), ue);
+        for (int i = g_partition.first; i < g_partition.first + g_partition.count; i++)
+        {
+            auto *config = GetConfigByUe(i);
+            // The subscriber table row of the UE is validated here, so that a malformed row fails the startup instead
+            // of terminating the process when the NAS task reads it
+            std::string name = config->getNodeName();
+            (void)config->getSubscription();
+            auto *ue = new nr::ue::UserEquipment(config, &g_ueController, nullptr, g_cliRespTask, g_executor,
+                                                 g_rlsDemux, g_hibernator, g_sharedTun);
+            g_ueMap.put(name, ue);
+            g_ueIds.put(i, ue);
+            ueList.push_back(ue);
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
     }
 
-    if (!g_options.disableCmd)
+    ReportMemoryUsage(ueList, residentBefore);
+
+    if (g_options.workers > 1)
+    {
+        std::vector<std::string> nodes{};
+        for (auto *ue : ueList)
+            nodes.push_back(ue->getConfig().getNodeName());
+        app::ReportToCoordinator(g_partition, nodes,
+                                 g_cliServer != nullptr ? g_cliServer->assignedAddress().getPort() : 0);
+    }
+    else if (!g_options.disableCmd)
     {
         app::CreateProcTable(g_ueMap, g_cliServer->assignedAddress().getPort());
-        g_cliRespTask->start();
     }
 
-    g_ueMap.invokeForeach([](const auto &ue) { ue.second->start(); });
+    if (!g_options.disableCmd)
+        g_cliRespTask->start();
+
+    if (g_launchProfile.type == app::ELaunchProfile::IMMEDIATE && g_launchProfile.jitter == 0)
+    {
+        g_ueMap.invokeForeach([](const auto &ue) { ue.second->start(); });
+    }
+    else
+    {
+        // The schedule is computed for all UEs, so that the workers together follow the profile
+        auto times = app::ComputeLaunchTimes(g_launchProfile, g_options.count);
+        auto begin = times.begin() + g_partition.first;
+        auto end = begin + g_partition.count;
+        std::cout << "Launching " << ueList.size() << " UEs with " << app::LaunchProfileName(g_launchProfile.type)
+                  << " profile in " << (begin == end ? 0 : *std::max_element(begin, end)) << " ms" << std::endl;
+
+        auto *w = new NwUeControllerCmd(NwUeControllerCmd::LAUNCH);
+        for (size_t i = 0; i < ueList.size(); i++)
+            w->launchList.emplace_back(begin[i], ueList[i]);
+        g_controllerTask->push(w);
+    }
 
     while (true)
         Loop();
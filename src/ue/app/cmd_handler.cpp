@@ -9,15 +9,18 @@
 #include "cmd_handler.hpp"
 
 #include <ue/app/task.hpp>
+#include <ue/nas/mm/mm.hpp>
+#include <ue/nas/sm/sm.hpp>
 #include <ue/nas/task.hpp>
+#include <ue/nas/usim/usim.hpp>
 #include <ue/rrc/task.hpp>
 #include <ue/rls/task.hpp>
 #include <ue/tun/task.hpp>
+#include <ue/ue.hpp>
 #include <utils/common.hpp>
+#include <utils/memory.hpp>
 #include <utils/printer.hpp>
-
-#define PAUSE_CONFIRM_TIMEOUT 3000
-#define PAUSE_POLLING 10
+#include <utils/scoped_thread.hpp>
 
 static std::string SignalDescription(int dbm)
 {
@@ -43,92 +46,149 @@ void UeCmdHandler::sendError(const InetAddress &address, const std::string &outp
     m_base->cliCallbackTask->push(new app::NwCliSendResponse(address, output, true));
 }
 
-void UeCmdHandler::pauseTasks()
+void UeCmdHandler::forward(NtsTask *task, NwUeCliCommand &msg)
 {
-    m_base->nasTask->requestPause();
-    m_base->rrcTask->requestPause();
-    m_base->rlsTask->requestPause();
+    auto *w = new NwUeCliCommand(std::move(msg.cmd), msg.address);
+    w->pduSessions = std::move(msg.pduSessions);
+    w->campedCell = std::move(msg.campedCell);
+    w->memory = msg.memory;
+    task->push(w);
 }
 
-void UeCmdHandler::unpauseTasks()
+void UeCmdHandler::handleCmd(NwUeCliCommand &msg)
 {
-    m_base->nasTask->requestUnpause();
-    m_base->rrcTask->requestUnpause();
-    m_base->rlsTask->requestUnpause();
+    switch (msg.cmd->present)
+    {
+    case app::UeCliCommand::STATUS: {
+        for (auto &pduSession : m_base->appTask->m_pduSessions)
+            if (pduSession.has_value())
+                msg.pduSessions.push_back(ToJson(*pduSession));
+        forward(m_base->rlsTask, msg);
+        break;
+    }
+    case app::UeCliCommand::COVERAGE: {
+        forward(m_base->rlsTask, msg);
+        break;
+    }
+    case app::UeCliCommand::TIMERS:
+    case app::UeCliCommand::DE_REGISTER:
+    case app::UeCliCommand::PS_RELEASE:
+    case app::UeCliCommand::PS_RELEASE_ALL:
+    case app::UeCliCommand::PS_ESTABLISH: {
+        forward(m_base->nasTask, msg);
+        break;
+    }
+    case app::UeCliCommand::INFO: {
+        sendResult(msg.address, ToJson(*m_base->config).dumpYaml());
+        break;
+    }
+    case app::UeCliCommand::QUEUE_STATS: {
+        Json json = Json::Obj({
+            {"nas", ToJson(m_base->nasTask->getQueueStats())},
+            {"rrc", ToJson(m_base->rrcTask->getQueueStats())},
+            {"rls", ToJson(m_base->rlsTask->getQueueStats())},
+            {"app", ToJson(m_base->appTask->getQueueStats())},
+        });
+        for (int psi = 0; psi < 16; psi++)
+        {
+            if (m_base->appTask->m_tunTasks[psi] != nullptr)
+                json.put("tun-" + std::to_string(psi), ToJson(m_base->appTask->m_tunTasks[psi]->getQueueStats()));
+        }
+        sendResult(msg.address, json.dumpYaml());
+        break;
+    }
+    case app::UeCliCommand::ALLOC_STATS: {
+        sendResult(msg.address, ToJson(NtsMessage::AllocatorStats()).dumpYaml());
+        break;
+    }
+    case app::UeCliCommand::MEMORY: {
+        addAppMemoryUsage(msg.memory);
+        if (m_base->ue->isHibernated())
+            sendMemoryUsage(msg);
+        else
+            forward(m_base->rrcTask, msg);
+        break;
+    }
+    }
 }
 
-bool UeCmdHandler::isAllPaused()
+void UeCmdHandler::handleRrcCmd(NwUeCliCommand &msg)
 {
-    if (!m_base->nasTask->isPauseConfirmed())
-        return false;
-    if (!m_base->rrcTask->isPauseConfirmed())
-        return false;
-    if (!m_base->rlsTask->isPauseConfirmed())
-        return false;
-    return true;
+    switch (msg.cmd->present)
+    {
+    case app::UeCliCommand::MEMORY: {
+        addRrcMemoryUsage(msg.memory);
+        forward(m_base->rlsTask, msg);
+        break;
+    }
+    default:
+        break;
+    }
 }
 
-void UeCmdHandler::handleCmd(NwUeCliCommand &msg)
+void UeCmdHandler::handleRlsCmd(NwUeCliCommand &msg)
 {
-    pauseTasks();
-
-    uint64_t currentTime = utils::CurrentTimeMillis();
-    uint64_t endTime = currentTime + PAUSE_CONFIRM_TIMEOUT;
-
-    bool isPaused = false;
-    while (currentTime < endTime)
+    switch (msg.cmd->present)
     {
-        currentTime = utils::CurrentTimeMillis();
-        if (isAllPaused())
+    case app::UeCliCommand::STATUS: {
+        msg.campedCell = m_base->rlsTask->m_servingCell.has_value() ? m_base->rlsTask->m_servingCell->gnbName : "";
+        forward(m_base->nasTask, msg);
+        break;
+    }
+    case app::UeCliCommand::COVERAGE: {
+        auto &map = m_base->rlsTask->m_activeMeasurements;
+        if (map.empty())
         {
-            isPaused = true;
+            sendResult(msg.address, "No cell exists in the range");
             break;
         }
-        utils::Sleep(PAUSE_POLLING);
-    }
 
-    if (!isPaused)
-    {
-        sendError(msg.address, "UE is unable process command due to pausing timeout");
+        std::vector<Json> cellInfo{};
+        for (auto &entry : map)
+        {
+            auto &measurement = entry.second;
+            cellInfo.push_back(Json::Obj({
+                {"gnb", measurement.gnbName},
+                {"plmn", ToJson(measurement.cellId.plmn)},
+                {"nci", measurement.cellId.nci},
+                {"tac", measurement.tac},
+                {"signal", std::to_string(measurement.dbm) + "dBm [" + SignalDescription(measurement.dbm) + "]"},
+            }));
+        }
+
+        sendResult(msg.address, Json::Arr(cellInfo).dumpYaml());
+        break;
     }
-    else
-    {
-        handleCmdImpl(msg);
+    case app::UeCliCommand::MEMORY: {
+        addRlsMemoryUsage(msg.memory);
+        forward(m_base->nasTask, msg);
+        break;
+    }
+    default:
+        break;
     }
-
-    unpauseTasks();
 }
 
-void UeCmdHandler::handleCmdImpl(NwUeCliCommand &msg)
+void UeCmdHandler::handleNasCmd(NwUeCliCommand &msg)
 {
     switch (msg.cmd->present)
     {
     case app::UeCliCommand::STATUS: {
-        std::vector<Json> pduSessions{};
-        for (auto &pduSession : m_base->appTask->m_pduSessions)
-            if (pduSession.has_value())
-                pduSessions.push_back(ToJson(*pduSession));
-
         Json json = Json::Obj({
             {"cm-state", ToJson(m_base->nasTask->mm->m_cmState)},
             {"rm-state", ToJson(m_base->nasTask->mm->m_rmState)},
             {"mm-state", ToJson(m_base->nasTask->mm->m_mmSubState)},
             {"5u-state", ToJson(m_base->nasTask->mm->m_usim->m_uState)},
-            {"camped-cell",
-             ::ToJson(m_base->rlsTask->m_servingCell.has_value() ? m_base->rlsTask->m_servingCell->gnbName : "")},
+            {"camped-cell", ::ToJson(msg.campedCell)},
             {"sim-inserted", m_base->nasTask->mm->m_usim->isValid()},
             {"stored-suci", ToJson(m_base->nasTask->mm->m_usim->m_storedSuci)},
             {"stored-guti", ToJson(m_base->nasTask->mm->m_usim->m_storedGuti)},
             {"has-emergency", ::ToJson(m_base->nasTask->mm->hasEmergency())},
-            {"pdu-sessions", Json::Arr(std::move(pduSessions))},
+            {"pdu-sessions", Json::Arr(std::move(msg.pduSessions))},
         });
         sendResult(msg.address, json.dumpYaml());
         break;
     }
-    case app::UeCliCommand::INFO: {
-        sendResult(msg.address, ToJson(*m_base->config).dumpYaml());
-        break;
-    }
     case app::UeCliCommand::TIMERS: {
         sendResult(msg.address, ToJson(m_base->nasTask->timers).dumpYaml());
         break;
@@ -163,31 +223,100 @@ void UeCmdHandler::handleCmdImpl(NwUeCliCommand &msg)
         sendResult(msg.address, "PDU session establishment procedure triggered");
         break;
     }
-    case app::UeCliCommand::COVERAGE: {
-        auto &map = m_base->rlsTask->m_activeMeasurements;
-        if (map.empty())
-        {
-            sendResult(msg.address, "No cell exists in the range");
-            break;
-        }
+    case app::UeCliCommand::MEMORY: {
+        addNasMemoryUsage(msg.memory);
+        sendMemoryUsage(msg);
+        break;
+    }
+    default:
+        break;
+    }
+}
 
-        std::vector<Json> cellInfo{};
-        for (auto &entry : map)
-        {
-            auto &measurement = entry.second;
-            cellInfo.push_back(Json::Obj({
-                {"gnb", measurement.gnbName},
-                {"plmn", ToJson(measurement.cellId.plmn)},
-                {"nci", measurement.cellId.nci},
-                {"tac", measurement.tac},
-                {"signal", std::to_string(measurement.dbm) + "dBm [" + SignalDescription(measurement.dbm) + "]"},
-            }));
-        }
+void UeCmdHandler::sendMemoryUsage(NwUeCliCommand &msg)
+{
+    Json json = Json::Obj({
+        {"ue", ToJson(msg.memory)},
+        {"process-rss", static_cast<int64_t>(utils::ResidentMemory())},
+    });
+    sendResult(msg.address, json.dumpYaml());
+}
 
-        sendResult(msg.address, Json::Arr(cellInfo).dumpYaml());
-        break;
+void UeCmdHandler::addAppMemoryUsage(UeMemoryUsage &usage)
+{
+    auto *appTask = m_base->appTask;
+
+    m_base->ue->addMemoryUsage(usage);
+    usage.app += sizeof(UeAppTask) + appTask->heapUsage() + utils::HeapUsage(appTask->m_msgBatch) +
+                 sizeof(UeUplinkFastPath);
+    usage.loggers += appTask->m_logger->memoryUsage();
+    if (m_base->executor == nullptr)
+        usage.threads++;
+
+    for (auto *tunTask : appTask->m_tunTasks)
+    {
+        if (tunTask == nullptr)
+            continue;
+        usage.tun += sizeof(TunTask) + tunTask->m_receivers.size() * sizeof(ScopedThread) + tunTask->heapUsage() +
+                     utils::HeapUsage(tunTask->m_fds) + utils::HeapUsage(tunTask->m_receivers) +
+                     utils::HeapUsage(tunTask->m_msgBatch);
+        // The receiver threads are always dedicated
+        usage.threads += tunTask->m_receivers.size() + (m_base->executor == nullptr ? 1 : 0);
     }
+}
+
+void UeCmdHandler::addRrcMemoryUsage(UeMemoryUsage &usage)
+{
+    auto *rrcTask = m_base->rrcTask;
+
+    usage.rrc += sizeof(UeRrcTask) + rrcTask->heapUsage() + static_cast<size_t>(rrcTask->m_initialNasPdu.length());
+    usage.loggers += rrcTask->m_logger->memoryUsage();
+    if (m_base->executor == nullptr)
+        usage.threads++;
+}
+
+void UeCmdHandler::addRlsMemoryUsage(UeMemoryUsage &usage)
+{
+    auto *rlsTask = m_base->rlsTask;
+
+    usage.rls += sizeof(UeRlsTask) + rlsTask->heapUsage() + utils::HeapUsage(rlsTask->m_cellSearchSpace) +
+                 utils::HeapUsage(rlsTask->m_pendingMeasurements) + utils::HeapUsage(rlsTask->m_activeMeasurements);
+    usage.loggers += rlsTask->m_logger->memoryUsage();
+    if (m_base->executor == nullptr)
+        usage.threads++;
+}
+
+void UeCmdHandler::addNasMemoryUsage(UeMemoryUsage &usage)
+{
+    auto *nasTask = m_base->nasTask;
+    auto *mm = nasTask->mm;
+    auto *sm = nasTask->sm;
+
+    // The timers are a part of the task
+    usage.nas += sizeof(NasTask) + nasTask->heapUsage() + sizeof(NasMm) + sizeof(NasSm) + sizeof(Usim);
+    if (mm->m_lastRegistrationRequest != nullptr)
+        usage.nas += sizeof(nas::RegistrationRequest);
+    if (mm->m_lastServiceRequest != nullptr)
+        usage.nas += sizeof(nas::ServiceRequest);
+    if (mm->m_lastDeregistrationRequest != nullptr)
+        usage.nas += sizeof(nas::DeRegistrationRequestUeOriginating);
+
+    for (auto *pduSession : sm->m_pduSessions)
+    {
+        if (pduSession != nullptr)
+            usage.nas += sizeof(PduSession);
     }
+    for (auto &pt : sm->m_procedureTransactions)
+    {
+        if (pt.timer != nullptr)
+            usage.nas += sizeof(nas::NasTimer);
+        if (pt.message != nullptr)
+            usage.nas += sizeof(nas::SmMessage);
+    }
+
+    usage.loggers += nasTask->logger->memoryUsage() + mm->m_logger->memoryUsage() + sm->m_logger->memoryUsage();
+    if (m_base->executor == nullptr)
+        usage.threads++;
 }
 
 } // namespace nr::ue
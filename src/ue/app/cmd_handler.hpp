@@ -24,15 +24,22 @@ class UeCmdHandler
     {
     }
 
+    // - Each command is handled by the task owning the state it reads or modifies, so the tasks are never paused.
+    // - handleCmd() is called by the App task, which forwards the command to the owning task if needed.
     void handleCmd(NwUeCliCommand &msg);
+    void handleRrcCmd(NwUeCliCommand &msg);
+    void handleRlsCmd(NwUeCliCommand &msg);
+    void handleNasCmd(NwUeCliCommand &msg);
 
-  private:
-    void pauseTasks();
-    void unpauseTasks();
-    bool isAllPaused();
+    // - Each one is called by the owning task, or by any thread before the UE is started.
+    void addAppMemoryUsage(UeMemoryUsage &usage);
+    void addRrcMemoryUsage(UeMemoryUsage &usage);
+    void addRlsMemoryUsage(UeMemoryUsage &usage);
+    void addNasMemoryUsage(UeMemoryUsage &usage);
 
   private:
-    void handleCmdImpl(NwUeCliCommand &msg);
+    void forward(NtsTask *task, NwUeCliCommand &msg);
+    void sendMemoryUsage(NwUeCliCommand &msg);
 
   private:
     void sendResult(const InetAddress &address, const std::string &output);
@@ -11,13 +11,20 @@
 #include <lib/nas/utils.hpp>
 #include <ue/nas/task.hpp>
 #include <ue/rls/task.hpp>
+#include <ue/tun/shared.hpp>
 #include <ue/tun/tun.hpp>
+#include <ue/uplink.hpp>
+#include <ue/ue.hpp>
 #include <utils/common.hpp>
 #include <utils/constants.hpp>
 
+#include <unistd.h>
+
 static constexpr const int SWITCH_OFF_TIMER_ID = 1;
 static constexpr const int SWITCH_OFF_DELAY = 500;
 
+static constexpr const int MSG_BATCH_SIZE = 64;
+
 namespace nr::ue
 {
 
@@ -32,27 +39,26 @@ void UeAppTask::onStart()
 
 void UeAppTask::onQuit()
 {
-    for (auto &tunTask : m_tunTasks)
-    {
-        if (tunTask != nullptr)
-        {
-            tunTask->quit();
-            delete tunTask;
-            tunTask = nullptr;
-        }
-    }
+    for (int psi = 0; psi < static_cast<int>(m_tunTasks.size()); psi++)
+        releaseTunInterface(psi);
+    m_base->uplinkFastPath->setOpenSessions(0);
 }
 
 void UeAppTask::onLoop()
 {
-    NtsMessage *msg = take();
-    if (!msg)
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
         return;
 
+    for (NtsMessage *msg : m_msgBatch)
+        handleMessage(msg);
+}
+
+void UeAppTask::handleMessage(NtsMessage *msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::UE_RLS_TO_APP: {
-        auto *w = dynamic_cast<NwUeRlsToApp *>(msg);
+        auto *w = NtsCast<NwUeRlsToApp>(msg);
         switch (w->present)
         {
         case NwUeRlsToApp::DATA_PDU_DELIVERY: {
@@ -62,7 +68,13 @@ void UeAppTask::onLoop()
                 auto *nw = new NwAppToTun(NwAppToTun::DATA_PDU_DELIVERY);
                 nw->psi = w->psi;
                 nw->data = std::move(w->pdu);
-                tunTask->push(nw);
+                tunTask->push(nw, NtsLane::BULK);
+            }
+            else if (!m_sharedTunAddresses[w->psi].empty())
+            {
+                std::string error{};
+                if (!m_base->sharedTun->write(w->pdu, error))
+                    m_logger->err("TUN failure [%s]", error.c_str());
             }
             break;
         }
@@ -70,11 +82,13 @@ void UeAppTask::onLoop()
         break;
     }
     case NtsMessageType::UE_TUN_TO_APP: {
-        auto *w = dynamic_cast<NwUeTunToApp *>(msg);
+        auto *w = NtsCast<NwUeTunToApp>(msg);
         switch (w->present)
         {
         case NwUeTunToApp::DATA_PDU_DELIVERY: {
-            handleUplinkDataRequest(w->psi, std::move(w->data));
+            wakeIfHibernated("uplink data");
+            for (auto &packet : w->packets)
+                handleUplinkDataRequest(w->psi, std::move(packet));
             break;
         }
         case NwUeTunToApp::TUN_ERROR: {
@@ -92,15 +106,34 @@ void UeAppTask::onLoop()
             setTimer(SWITCH_OFF_TIMER_ID, SWITCH_OFF_DELAY);
             break;
         }
+        case NwUeNasToApp::HIBERNATE: {
+            m_base->ue->hibernate();
+            if (m_base->ue->isHibernated())
+                m_logger->debug("UE is hibernated");
+            break;
+        }
         }
         break;
     }
+    case NtsMessageType::UE_WAKE_UP: {
+        auto *w = dynamic_cast<NwUeWakeUp *>(msg);
+        wakeIfHibernated(w->packet != nullptr ? "RLS message" : "timer or cell change");
+
+        // The message is handled by the RLS task, as if it was received while the UE was awake
+        if (w->packet != nullptr)
+            m_base->rlsTask->push(w->packet.release());
+        break;
+    }
     case NtsMessageType::UE_STATUS_UPDATE: {
         receiveStatusUpdate(*dynamic_cast<NwUeStatusUpdate *>(msg));
+        publishUplinkState();
         break;
     }
     case NtsMessageType::UE_CLI_COMMAND: {
         auto *w = dynamic_cast<NwUeCliCommand *>(msg);
+        // The memory usage of a hibernated UE is reported as is
+        if (w->cmd->present != app::UeCliCommand::MEMORY)
+            wakeIfHibernated("CLI command");
         UeCmdHandler handler{m_base};
         handler.handleCmd(*w);
         break;
@@ -121,6 +154,15 @@ void UeAppTask::onLoop()
     delete msg;
 }
 
+void UeAppTask::wakeIfHibernated(const char *reason)
+{
+    if (!m_base->ue->isHibernated())
+        return;
+
+    m_logger->debug("UE is waking up for %s", reason);
+    m_base->ue->wake();
+}
+
 void UeAppTask::receiveStatusUpdate(NwUeStatusUpdate &msg)
 {
     if (msg.what == NwUeStatusUpdate::SESSION_ESTABLISHMENT)
@@ -143,12 +185,7 @@ void UeAppTask::receiveStatusUpdate(NwUeStatusUpdate &msg)
 
     if (msg.what == NwUeStatusUpdate::SESSION_RELEASE)
     {
-        if (m_tunTasks[msg.psi] != nullptr)
-        {
-            m_tunTasks[msg.psi]->quit();
-            delete m_tunTasks[msg.psi];
-            m_tunTasks[msg.psi] = nullptr;
-        }
+        releaseTunInterface(msg.psi);
 
         if (m_pduSessions[msg.psi].has_value())
         {
@@ -193,15 +230,21 @@ void UeAppTask::setupTunInterface(const PduSession *pduSession)
         return;
     }
 
-    if (m_tunTasks[psi] != nullptr)
+    if (m_tunTasks[psi] != nullptr || !m_sharedTunAddresses[psi].empty())
     {
-        m_logger->err("Connection could not setup. TUN task for specified PSI is non-null.");
+        m_logger->err("Connection could not setup. TUN interface for specified PSI is already setup.");
+        return;
+    }
+
+    if (m_base->sharedTun != nullptr)
+    {
+        setupSharedTunInterface(psi, utils::OctetStringToIp(pduSession->pduAddress->pduAddressInformation));
         return;
     }
 
     std::string error{}, allocatedName{};
-    int fd = tun::TunAllocate(cons::TunNamePrefix, allocatedName, error);
-    if (fd == 0 || error.length() > 0)
+    std::vector<int> fds{};
+    if (!tun::TunAllocate(cons::TunNamePrefix, m_base->config->base->tunQueues, allocatedName, fds, error))
     {
         m_logger->err("TUN allocation failure [%s]", error.c_str());
         return;
@@ -209,22 +252,71 @@ void UeAppTask::setupTunInterface(const PduSession *pduSession)
 
     std::string ipAddress = utils::OctetStringToIp(pduSession->pduAddress->pduAddressInformation);
 
-    bool r = tun::TunConfigure(allocatedName, ipAddress, cons::TunMtu, m_base->config->configureRouting, error);
+    bool r = tun::TunConfigure(allocatedName, ipAddress, cons::TunMtu, m_base->config->base->configureRouting, error);
     if (!r || error.length() > 0)
     {
         m_logger->err("TUN configuration failure [%s]", error.c_str());
+        for (int fd : fds)
+            ::close(fd);
         return;
     }
 
-    auto *task = new TunTask(m_base, psi, fd);
+    auto *task = new TunTask(m_base, psi, std::move(fds));
     m_tunTasks[psi] = task;
-    task->start();
+    task->setQueueCapacity(m_base->config->base->queueCapacity, m_base->config->base->queuePolicy);
+    task->start(m_base->executor);
 
     m_logger->info("Connection setup for PDU session[%d] is successful, TUN interface[%s, %s] is up.", pduSession->psi,
                    allocatedName.c_str(), ipAddress.c_str());
 }
 
-void UeAppTask::handleUplinkDataRequest(int psi, OctetString &&data)
+void UeAppTask::setupSharedTunInterface(int psi, const std::string &ipAddress)
+{
+    std::string error{};
+    if (!m_base->sharedTun->attach(ipAddress, psi, this, m_base->uplinkFastPath, error))
+    {
+        m_logger->err("TUN configuration failure [%s]", error.c_str());
+        return;
+    }
+    m_sharedTunAddresses[psi] = ipAddress;
+
+    m_logger->info("Connection setup for PDU session[%d] is successful, TUN interface[%s, %s] is up.", psi,
+                   m_base->sharedTun->name().c_str(), ipAddress.c_str());
+}
+
+void UeAppTask::releaseTunInterface(int psi)
+{
+    if (m_tunTasks[psi] != nullptr)
+    {
+        m_tunTasks[psi]->quit();
+        delete m_tunTasks[psi];
+        m_tunTasks[psi] = nullptr;
+    }
+
+    if (!m_sharedTunAddresses[psi].empty())
+    {
+        m_base->sharedTun->detach(m_sharedTunAddresses[psi]);
+        m_sharedTunAddresses[psi] = {};
+    }
+}
+
+void UeAppTask::publishUplinkState()
+{
+    // The pending uplink data is reported to NAS by the slow path, so such a session is not opened until then
+    uint32_t psiMask = 0;
+    if (m_cmState == ECmState::CM_CONNECTED)
+    {
+        for (int psi = 0; psi < static_cast<int>(m_pduSessions.size()); psi++)
+        {
+            bool hasTun = m_tunTasks[psi] != nullptr || !m_sharedTunAddresses[psi].empty();
+            if (hasTun && m_pduSessions[psi].has_value() && !m_pduSessions[psi]->uplinkPending)
+                psiMask |= 1u << psi;
+        }
+    }
+    m_base->uplinkFastPath->setOpenSessions(psiMask);
+}
+
+void UeAppTask::handleUplinkDataRequest(int psi, PacketBuffer &&data)
 {
     if (!m_pduSessions[psi].has_value())
         return;
@@ -234,6 +326,7 @@ void UeAppTask::handleUplinkDataRequest(int psi, OctetString &&data)
         if (m_pduSessions[psi]->uplinkPending)
         {
             m_pduSessions[psi]->uplinkPending = false;
+            publishUplinkState();
 
             auto *w = new NwUeAppToNas(NwUeAppToNas::UPLINK_STATUS_CHANGE);
             w->psi = psi;
@@ -244,13 +337,14 @@ void UeAppTask::handleUplinkDataRequest(int psi, OctetString &&data)
         auto *nw = new NwUeAppToRls(NwUeAppToRls::DATA_PDU_DELIVERY);
         nw->psi = psi;
         nw->pdu = std::move(data);
-        m_base->rlsTask->push(nw);
+        m_base->rlsTask->push(nw, NtsLane::BULK);
     }
     else
     {
         if (!m_pduSessions[psi]->uplinkPending)
         {
             m_pduSessions[psi]->uplinkPending = true;
+            publishUplinkState();
 
             auto *w = new NwUeAppToNas(NwUeAppToNas::UPLINK_STATUS_CHANGE);
             w->psi = psi;
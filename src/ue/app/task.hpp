@@ -29,7 +29,9 @@ class UeAppTask : public NtsTask
 
     std::array<std::optional<UePduSessionInfo>, 16> m_pduSessions{};
     std::array<TunTask *, 16> m_tunTasks{};
+    std::array<std::string, 16> m_sharedTunAddresses{}; // Addresses attached to the shared TUN interface
     ECmState m_cmState{};
+    std::vector<NtsMessage *> m_msgBatch{};
 
     friend class UeCmdHandler;
 
@@ -42,10 +44,17 @@ class UeAppTask : public NtsTask
     void onLoop() override;
     void onQuit() override;
 
+  private:
+    void handleMessage(NtsMessage *msg);
+
   private:
     void receiveStatusUpdate(NwUeStatusUpdate &msg);
     void setupTunInterface(const PduSession *pduSession);
-    void handleUplinkDataRequest(int psi, OctetString &&data);
+    void setupSharedTunInterface(int psi, const std::string &ipAddress);
+    void releaseTunInterface(int psi);
+    void publishUplinkState();
+    void handleUplinkDataRequest(int psi, PacketBuffer &&data);
+    void wakeIfHibernated(const char *reason);
 };
 
 } // namespace nr::ue
@@ -0,0 +1,300 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "hibernation.hpp"
+#include "nts.hpp"
+
+#include <lib/asn/utils.hpp>
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/rrc/rrc.hpp>
+#include <lib/rrc/encode.hpp>
+#include <ue/nas/usim/usim.hpp>
+#include <ue/rls/demux.hpp>
+#include <utils/bit_buffer.hpp>
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+
+#include <thread>
+
+#include <asn/rrc/ASN_RRC_PCCH-Message.h>
+#include <asn/rrc/ASN_RRC_Paging.h>
+#include <asn/rrc/ASN_RRC_PagingRecord.h>
+#include <asn/rrc/ASN_RRC_PagingRecordList.h>
+
+static constexpr const int TIMER_ID_HEARTBEAT = 1;
+static constexpr const int TIMER_PERIOD_HEARTBEAT = 1000;
+
+// The RLS task detects the loss of the serving cell after a measurement period without a response, a hibernated UE
+// is woken up a bit later so that the RLS task detects it as well.
+static constexpr const int64_t CELL_LOST_THRESHOLD = 2500;
+
+static constexpr const int MSG_BATCH_SIZE = 64;
+
+namespace nr::ue
+{
+
+UeHibernationRecord::UeHibernationRecord() = default;
+
+UeHibernationRecord::~UeHibernationRecord() = default;
+
+UeHibernator::UeHibernator(UeRlsDemux *demux, const std::vector<std::string> &gnbSearchList, bool passiveMeasurement)
+    : m_demux{demux}, m_searchSpace{}, m_isPassive{passiveMeasurement}, m_msgBatch{}, m_lastPagingPdu{},
+      m_lastPagingTmsi{}, m_mutex{}, m_entries{}, m_wakeUps{},
+      m_wakeEpoch{}
+{
+    for (auto &addr : gnbSearchList)
+        m_searchSpace.emplace_back(addr, cons::PortalPort);
+}
+
+void UeHibernator::add(uint64_t sti, NtsTask *appTask, const UeHibernationRecord &record)
+{
+    Entry entry{};
+    entry.appTask = appTask;
+    entry.wakeTime = record.wakeTime;
+    entry.lastSeen = utils::CurrentTimeMillis();
+    entry.lastRequest = entry.lastSeen;
+    if (record.servingCell.has_value())
+        entry.servingCell = record.servingCell->cellId;
+    if (record.usim != nullptr && record.usim->m_storedGuti.type != nas::EIdentityType::NO_IDENTITY)
+        entry.tmsi = record.usim->m_storedGuti.gutiOrTmsi;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_entries[sti] = entry;
+    }
+    m_demux->attach(sti, this);
+}
+
+void UeHibernator::remove(uint64_t sti)
+{
+    m_demux->detach(sti);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_entries.erase(sti);
+    }
+
+    // A notification collected before the entry is erased may still be being pushed to the app task. The hibernator
+    // never blocks on a push, so this is short.
+    uint64_t epoch = m_wakeEpoch.load();
+    while ((epoch & 1) != 0 && m_wakeEpoch.load() == epoch)
+        std::this_thread::yield();
+}
+
+size_t UeHibernator::count() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void UeHibernator::onStart()
+{
+    setPeriodicTimer(TIMER_ID_HEARTBEAT, TIMER_PERIOD_HEARTBEAT);
+}
+
+void UeHibernator::onLoop()
+{
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
+        return;
+
+    for (NtsMessage *msg : m_msgBatch)
+    {
+        switch (msg->msgType)
+        {
+        case NtsMessageType::TIMER_EXPIRED: {
+            if (dynamic_cast<NwTimerExpired *>(msg)->timerId == TIMER_ID_HEARTBEAT)
+                onHeartbeat();
+            delete msg;
+            break;
+        }
+        case NtsMessageType::UDP_SERVER_RECEIVE:
+            receiveRlsMessage(NtsCast<udp::NwUdpServerReceive>(msg));
+            break;
+        default:
+            delete msg;
+            break;
+        }
+    }
+}
+
+void UeHibernator::onQuit()
+{
+}
+
+void UeHibernator::onHeartbeat()
+{
+    std::vector<uint64_t> stiList{};
+
+    {
+        int64_t current = utils::CurrentTimeMillis();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        stiList.reserve(m_entries.size());
+
+        for (auto &item : m_entries)
+        {
+            auto &entry = item.second;
+            if (entry.isWaking)
+                continue;
+
+            if (entry.wakeTime != 0 && current >= entry.wakeTime)
+                wake(entry, nullptr);
+            else if (entry.servingCell.has_value() && current - entry.lastSeen > CELL_LOST_THRESHOLD)
+                wake(entry, nullptr);
+            else if (!m_isPassive || current - entry.lastRequest >= rls::BEACON_KEEPALIVE_PERIOD)
+            {
+                entry.lastRequest = current;
+                stiList.push_back(item.first);
+            }
+        }
+    }
+
+    pushWakeUps();
+
+    // The messages are sent without holding the lock, so that the app tasks are not blocked by a large population
+    OctetString stream{};
+    for (uint64_t sti : stiList)
+    {
+        stream = {};
+        rls::EncodeRlsMessage(rls::RlsCellInfoRequest{sti}, stream);
+        for (auto &address : m_searchSpace)
+            m_demux->send(sti, address, stream);
+    }
+}
+
+void UeHibernator::receiveRlsMessage(udp::NwUdpServerReceive *msg)
+{
+    uint64_t sti = rls::PeekTargetSti(msg->packet.data(), static_cast<size_t>(msg->packet.length()));
+    auto rlsMsg = rls::DecodeRlsMessage(OctetView{msg->packet});
+    if (rlsMsg == nullptr)
+    {
+        delete msg;
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        handleRlsMessage(sti, *rlsMsg, msg);
+    }
+
+    pushWakeUps();
+}
+
+void UeHibernator::handleRlsMessage(uint64_t sti, const rls::RlsMessage &rlsMsg, udp::NwUdpServerReceive *msg)
+{
+    auto it = m_entries.find(sti);
+    if (it == m_entries.end())
+    {
+        delete msg;
+        return;
+    }
+    auto &entry = it->second;
+
+    if (entry.isWaking)
+    {
+        // The UE is being woken up, the messages are handed over to its RLS task
+        wake(entry, msg);
+        return;
+    }
+
+    if (rlsMsg.msgType == rls::EMessageType::CELL_INFO_RESPONSE)
+    {
+        auto &response = (const rls::RlsCellInfoResponse &)rlsMsg;
+        if (entry.servingCell.has_value() && response.cellId == *entry.servingCell)
+            entry.lastSeen = utils::CurrentTimeMillis();
+        delete msg;
+        return;
+    }
+
+    if (rlsMsg.msgType == rls::EMessageType::PDU_DELIVERY)
+    {
+        auto &delivery = (const rls::RlsPduDelivery &)rlsMsg;
+        bool isPaging = delivery.pduType == rls::EPduType::RRC &&
+                        static_cast<rrc::RrcChannel>(delivery.payload.get4I(0)) == rrc::RrcChannel::PCCH;
+
+        // Paging for the other UEs is ignored, any other PDU wakes the UE up
+        if (isPaging && !isPaged(entry, delivery.pdu))
+        {
+            delete msg;
+            return;
+        }
+
+        wake(entry, msg);
+        return;
+    }
+
+    delete msg;
+}
+
+bool UeHibernator::isPaged(const Entry &entry, const OctetString &pagingPdu)
+{
+    if (!entry.tmsi.has_value())
+        return false;
+
+    if (m_lastPagingPdu.length() == 0 || !(m_lastPagingPdu == pagingPdu))
+    {
+        m_lastPagingPdu = pagingPdu.copy();
+        m_lastPagingTmsi.clear();
+
+        auto *pdu = rrc::encode::Decode<ASN_RRC_PCCH_Message>(asn_DEF_ASN_RRC_PCCH_Message, pagingPdu);
+        if (pdu != nullptr && pdu->message.present == ASN_RRC_PCCH_MessageType_PR_c1 &&
+            pdu->message.choice.c1->present == ASN_RRC_PCCH_MessageType__c1_PR_paging &&
+            pdu->message.choice.c1->choice.paging->pagingRecordList != nullptr)
+        {
+            asn::ForeachItem(*pdu->message.choice.c1->choice.paging->pagingRecordList, [this](auto &pagingRecord) {
+                if (pagingRecord.ue_Identity.present == ASN_RRC_PagingUE_Identity_PR_ng_5G_S_TMSI)
+                {
+                    auto recordTmsi = asn::GetOctetString(pagingRecord.ue_Identity.choice.ng_5G_S_TMSI);
+                    auto tmsiOs = BitBuffer{recordTmsi.data()};
+
+                    GutiMobileIdentity tmsi{};
+                    tmsi.amfSetId = tmsiOs.readBits(10);
+                    tmsi.amfPointer = tmsiOs.readBits(6);
+                    tmsi.tmsi = octet4{static_cast<uint32_t>(tmsiOs.readBitsLong(32) & 0xFFFFFFFFu)};
+                    m_lastPagingTmsi.push_back(tmsi);
+                }
+            });
+        }
+        if (pdu != nullptr)
+            asn::Free(asn_DEF_ASN_RRC_PCCH_Message, pdu);
+    }
+
+    for (auto &tmsi : m_lastPagingTmsi)
+    {
+        if (tmsi.amfSetId == entry.tmsi->amfSetId && tmsi.amfPointer == entry.tmsi->amfPointer &&
+            tmsi.tmsi == entry.tmsi->tmsi)
+            return true;
+    }
+    return false;
+}
+
+void UeHibernator::wake(Entry &entry, udp::NwUdpServerReceive *packet)
+{
+    entry.isWaking = true;
+
+    auto *w = new NwUeWakeUp();
+    w->packet.reset(packet);
+
+    // Made odd while m_mutex is held, so that remove() cannot miss a notification being pushed
+    if (m_wakeUps.empty())
+        m_wakeEpoch++;
+    m_wakeUps.emplace_back(entry.appTask, w);
+}
+
+void UeHibernator::pushWakeUps()
+{
+    if (m_wakeUps.empty())
+        return;
+
+    for (auto &item : m_wakeUps)
+        item.first->push(item.second);
+    m_wakeUps.clear();
+    m_wakeEpoch++;
+}
+
+} // namespace nr::ue
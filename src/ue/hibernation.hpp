@@ -0,0 +1,124 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/udp/server_task.hpp>
+#include <utils/common_types.hpp>
+#include <utils/network.hpp>
+#include <utils/nts.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::ue
+{
+
+class Usim;
+
+// State of a hibernated UE, which is enough to recreate its NAS, RRC and RLS tasks.
+// - The RRC state of a hibernated UE is always RRC_IDLE, hence it is not kept.
+struct UeHibernationRecord
+{
+    /* NAS */
+    ERmState rmState{};
+    ECmState cmState{};
+    EMmState mmState{};
+    EMmSubState mmSubState{};
+    bool registeredForEmergency{};
+    nas::IE5gsNetworkFeatureSupport nwFeatureSupport{};
+    std::unique_ptr<Usim> usim{};
+    std::unique_ptr<UeTimers> timers{};
+    std::array<std::unique_ptr<PduSession>, 16> pduSessions{};
+
+    /* RLS */
+    uint64_t sti{};
+    std::optional<UeCellInfo> servingCell{};
+
+    // Time in terms of utils::CurrentTimeMillis() at which the UE must be woken up for a NAS timer, zero if none
+    int64_t wakeTime{};
+
+    UeHibernationRecord();
+    ~UeHibernationRecord();
+};
+
+// Keeps the hibernated UEs of the process reachable, in place of their RLS tasks.
+// - Sends the periodic cell info requests of every hibernated UE, so that the gNBs keep them in coverage. With passive
+//   measurement, only the keepalive requests are sent and the beacons are listened to.
+// - Wakes a UE up by notifying its app task when it is paged, when its serving cell is lost, or when a NAS timer is
+//   about to expire. The app task also wakes the UE up for a CLI command or uplink data.
+// - Works on the shared RLS sockets, the RLS messages of a hibernated UE are routed to this task by its STI.
+class UeHibernator : public NtsTask
+{
+  private:
+    struct Entry
+    {
+        NtsTask *appTask{};
+        int64_t wakeTime{};
+        std::optional<GlobalNci> servingCell{};
+        int64_t lastSeen{};
+        std::optional<GutiMobileIdentity> tmsi{};
+        bool isWaking{};
+        int64_t lastRequest{};
+    };
+
+    UeRlsDemux *m_demux;
+    std::vector<InetAddress> m_searchSpace;
+    bool m_isPassive;
+    std::vector<NtsMessage *> m_msgBatch;
+
+    // Paging is broadcast to every UE, hence the last paging PDU is decoded once for all of them
+    OctetString m_lastPagingPdu;
+    std::vector<GutiMobileIdentity> m_lastPagingTmsi;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, Entry> m_entries;
+
+    // The wake up notifications are pushed after m_mutex is released, the epoch is odd meanwhile, see remove()
+    std::vector<std::pair<NtsTask *, NtsMessage *>> m_wakeUps;
+    std::atomic<uint64_t> m_wakeEpoch;
+
+  public:
+    UeHibernator(UeRlsDemux *demux, const std::vector<std::string> &gnbSearchList, bool passiveMeasurement);
+    ~UeHibernator() override = default;
+
+    // - Called by the app task of the UE after its other tasks are torn down.
+    void add(uint64_t sti, NtsTask *appTask, const UeHibernationRecord &record);
+    // - Called by the app task of the UE before its other tasks are recreated. No wake up notification is sent to
+    // the app task after this returns.
+    void remove(uint64_t sti);
+    [[nodiscard]] size_t count() const;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  private:
+    void onHeartbeat();
+    void receiveRlsMessage(udp::NwUdpServerReceive *msg);
+    // Takes the ownership of the packet, m_mutex must be held
+    void handleRlsMessage(uint64_t sti, const rls::RlsMessage &rlsMsg, udp::NwUdpServerReceive *msg);
+    bool isPaged(const Entry &entry, const OctetString &pagingPdu);
+    // Takes the ownership of the packet, m_mutex must be held. The notification is sent by pushWakeUps().
+    void wake(Entry &entry, udp::NwUdpServerReceive *packet);
+    // m_mutex must not be held
+    void pushWakeUps();
+};
+
+} // namespace nr::ue
@@ -29,7 +29,7 @@ void DeriveKeysSeafAmf(const UeConfig &ueConfig, const Plmn &currentPlmn, NasSec
     s1[0] = crypto::EncodeKdfString(snn);
 
     OctetString s2[2];
-    s2[0] = crypto::EncodeKdfString(ueConfig.supi->value);
+    s2[0] = crypto::EncodeKdfString(ueConfig.getSupi()->value);
     s2[1] = keys.abba.copy();
 
     keys.kSeaf = crypto::CalculateKdfKey(keys.kAusf, 0x6C, s1, 1);
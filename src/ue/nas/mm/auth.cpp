@@ -161,7 +161,7 @@ void NasMm::receiveAuthenticationRequestEap(const nas::AuthenticationRequest &ms
         auto &ckPrime = ckPrimeIkPrime.first;
         auto &ikPrime = ckPrimeIkPrime.second;
 
-        auto mk = keys::CalculateMk(ckPrime, ikPrime, m_base->config->supi.value());
+        auto mk = keys::CalculateMk(ckPrime, ikPrime, m_base->config->getSupi().value());
         auto kaut = mk.subCopy(16, 32);
 
         // Check the received AT_MAC
@@ -498,13 +498,14 @@ EAutnValidationRes NasMm::validateAutn(const OctetString &rand, const OctetStrin
 
 crypto::milenage::Milenage NasMm::calculateMilenage(const OctetString &sqn, const OctetString &rand, bool dummyAmf)
 {
-    OctetString amf = dummyAmf ? OctetString::FromSpare(2) : m_base->config->amf.copy();
+    auto subscription = m_base->config->getSubscription();
+    OctetString amf = dummyAmf ? OctetString::FromSpare(2) : std::move(subscription.amf);
 
-    if (m_base->config->opType == OpType::OPC)
-        return crypto::milenage::Calculate(m_base->config->opC, m_base->config->key, rand, sqn, amf);
+    if (subscription.opType == OpType::OPC)
+        return crypto::milenage::Calculate(subscription.opC, subscription.key, rand, sqn, amf);
 
-    OctetString opc = crypto::milenage::CalculateOpC(m_base->config->opC, m_base->config->key);
-    return crypto::milenage::Calculate(opc, m_base->config->key, rand, sqn, amf);
+    OctetString opc = crypto::milenage::CalculateOpC(subscription.opC, subscription.key);
+    return crypto::milenage::Calculate(opc, subscription.key, rand, sqn, amf);
 }
 
 bool NasMm::networkFailingTheAuthCheck(bool hasChance)
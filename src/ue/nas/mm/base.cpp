@@ -10,6 +10,7 @@
 
 #include <lib/nas/utils.hpp>
 #include <ue/app/task.hpp>
+#include <ue/hibernation.hpp>
 #include <ue/nas/task.hpp>
 #include <ue/nas/usim/usim.hpp>
 #include <ue/rrc/task.hpp>
@@ -40,6 +41,34 @@ void NasMm::onQuit()
     // TODO
 }
 
+bool NasMm::isIdleForHibernation() const
+{
+    return m_rmState == ERmState::RM_REGISTERED && m_cmState == ECmState::CM_IDLE &&
+           m_mmState == EMmState::MM_REGISTERED && m_mmSubState == EMmSubState::MM_REGISTERED_NORMAL_SERVICE &&
+           m_usim->m_uState == E5UState::U1_UPDATED && m_usim->m_servingCell.has_value();
+}
+
+void NasMm::saveState(UeHibernationRecord &record) const
+{
+    record.rmState = m_rmState;
+    record.cmState = m_cmState;
+    record.mmState = m_mmState;
+    record.mmSubState = m_mmSubState;
+    record.registeredForEmergency = m_registeredForEmergency;
+    record.nwFeatureSupport = m_nwFeatureSupport;
+}
+
+void NasMm::restoreState(const UeHibernationRecord &record)
+{
+    // The states are restored without switching, since the other tasks are already in line with them
+    m_rmState = record.rmState;
+    m_cmState = record.cmState;
+    m_mmState = record.mmState;
+    m_mmSubState = record.mmSubState;
+    m_registeredForEmergency = record.registeredForEmergency;
+    m_nwFeatureSupport = record.nwFeatureSupport;
+}
+
 void NasMm::triggerMmCycle()
 {
     m_base->nasTask->push(new NwUeNasToNas(NwUeNasToNas::PERFORM_MM_CYCLE));
@@ -24,12 +24,12 @@ void NasMm::receiveIdentityRequest(const nas::IdentityRequest &msg)
     else if (msg.identityType.value == nas::EIdentityType::IMEI)
     {
         resp.mobileIdentity.type = nas::EIdentityType::IMEI;
-        resp.mobileIdentity.value = *m_base->config->imei;
+        resp.mobileIdentity.value = *m_base->config->getImei();
     }
     else if (msg.identityType.value == nas::EIdentityType::IMEISV)
     {
         resp.mobileIdentity.type = nas::EIdentityType::IMEISV;
-        resp.mobileIdentity.value = *m_base->config->imeiSv;
+        resp.mobileIdentity.value = *m_base->config->getImeiSv();
     }
     else if (msg.identityType.value == nas::EIdentityType::GUTI)
     {
@@ -70,8 +70,8 @@ nas::IE5gsMobileIdentity NasMm::getOrGenerateSuci()
 
 nas::IE5gsMobileIdentity NasMm::generateSuci()
 {
-    auto &supi = m_base->config->supi;
-    auto &plmn = m_base->config->hplmn;
+    auto supi = m_base->config->getSupi();
+    auto &plmn = m_base->config->base->hplmn;
 
     if (!supi.has_value())
         return {};
@@ -107,18 +107,18 @@ nas::IE5gsMobileIdentity NasMm::getOrGeneratePreferredId()
     {
         return suci;
     }
-    else if (m_base->config->imei.has_value())
+    else if (m_base->config->base->imei.has_value())
     {
         nas::IE5gsMobileIdentity res{};
         res.type = nas::EIdentityType::IMEI;
-        res.value = *m_base->config->imei;
+        res.value = *m_base->config->getImei();
         return res;
     }
-    else if (m_base->config->imeiSv.has_value())
+    else if (m_base->config->base->imeiSv.has_value())
     {
         nas::IE5gsMobileIdentity res{};
         res.type = nas::EIdentityType::IMEISV;
-        res.value = *m_base->config->imeiSv;
+        res.value = *m_base->config->getImeiSv();
         return res;
     }
     else
@@ -181,6 +181,11 @@ class NasMm
     bool isRegistered();                          // used by SM
     bool isRegisteredForEmergency();              // used by SM
     void serviceNeededForUplinkData();            // used by SM
+
+  public: /* Hibernation */
+    [[nodiscard]] bool isIdleForHibernation() const;
+    void saveState(UeHibernationRecord &record) const;
+    void restoreState(const UeHibernationRecord &record);
 };
 
 } // namespace nr::ue
\ No newline at end of file
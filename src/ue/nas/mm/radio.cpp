@@ -85,7 +85,7 @@ void NasMm::handlePlmnSearchResponse(const std::vector<UeCellMeasurement> &measu
             continue;
         }
 
-        if (item.cellId.plmn == m_base->config->hplmn || item.cellId.plmn == m_usim->m_currentPlmn ||
+        if (item.cellId.plmn == m_base->config->base->hplmn || item.cellId.plmn == m_usim->m_currentPlmn ||
             nas::utils::PlmnListContains(m_usim->m_equivalentPlmnList, item.cellId.plmn))
         {
             suitable.push_back(item);
@@ -8,6 +8,8 @@
 
 #include "sm.hpp"
 
+#include <ue/hibernation.hpp>
+
 namespace nr::ue
 {
 
@@ -19,6 +21,12 @@ NasSm::NasSm(TaskBase *base, UeTimers *timers) : m_base(base), m_timers(timers),
         m_pduSessions[i] = new PduSession(i);
 }
 
+NasSm::~NasSm()
+{
+    for (auto *session : m_pduSessions)
+        delete session;
+}
+
 void NasSm::onStart(NasMm *mm)
 {
     m_mm = mm;
@@ -29,17 +37,54 @@ void NasSm::onQuit()
     // TODO
 }
 
+bool NasSm::isIdleForHibernation() const
+{
+    for (auto &pt : m_procedureTransactions)
+    {
+        if (pt.state != EPtState::INACTIVE)
+            return false;
+    }
+
+    for (auto *session : m_pduSessions)
+    {
+        if (session->psState != EPsState::ACTIVE && session->psState != EPsState::INACTIVE)
+            return false;
+        if (session->uplinkPending)
+            return false;
+    }
+    return true;
+}
+
+void NasSm::saveState(UeHibernationRecord &record)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        record.pduSessions[i].reset(m_pduSessions[i]);
+        m_pduSessions[i] = new PduSession(i);
+    }
+}
+
+void NasSm::restoreState(UeHibernationRecord &record)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        delete m_pduSessions[i];
+        m_pduSessions[i] = record.pduSessions[i].release();
+    }
+}
+
 void NasSm::establishInitialSessions()
 {
-    if (m_base->config->initSessions.empty())
+    auto sessions = m_base->config->getSubscription().sessions;
+    if (sessions.empty())
     {
         m_logger->warn("No initial PDU sessions are configured");
         return;
     }
 
-    m_logger->info("Initial PDU sessions are establishing [%d#]", m_base->config->initSessions.size());
+    m_logger->info("Initial PDU sessions are establishing [%d#]", sessions.size());
 
-    for (auto &sess : m_base->config->initSessions)
+    for (auto &sess : sessions)
         sendEstablishmentRequest(sess);
 }
 
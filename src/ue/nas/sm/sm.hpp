@@ -36,6 +36,7 @@ class NasSm
 
   public:
     NasSm(TaskBase *base, UeTimers *timers);
+    ~NasSm();
 
   public:
     /* Base */
@@ -97,6 +98,11 @@ class NasSm
     /* Interface */
     void handleNasEvent(const NwUeNasToNas &msg); // used by NAS
     void onTimerTick();                           // used by NAS
+
+    /* Hibernation */
+    [[nodiscard]] bool isIdleForHibernation() const;
+    void saveState(UeHibernationRecord &record);
+    void restoreState(UeHibernationRecord &record);
 };
 
 } // namespace nr::ue
\ No newline at end of file
@@ -7,45 +7,85 @@
 //
 
 #include "task.hpp"
+#include <climits>
+#include <ue/app/cmd_handler.hpp>
+#include <ue/app/task.hpp>
+#include <ue/hibernation.hpp>
 #include <ue/nts.hpp>
+#include <utils/common.hpp>
 
 static const int NTS_TIMER_ID_NAS_TIMER_CYCLE = 1;
 static const int NTS_TIMER_ID_MM_CYCLE = 2;
 static const int NTS_TIMER_INTERVAL_NAS_TIMER_CYCLE = 1000;
 static const int NTS_TIMER_INTERVAL_MM_CYCLE = 1100;
 
+// A UE is not hibernated if a NAS timer expires in this many seconds, and it is woken up this early otherwise
+static const int HIBERNATION_TIMER_MARGIN = 5;
+
+// Returns the remaining seconds of the running NAS timer which expires first, INT_MAX if none is running
+static int NearestTimerExpiry(const nr::ue::UeTimers &timers)
+{
+    const nas::NasTimer *list[] = {&timers.t3346, &timers.t3396, &timers.t3444, &timers.t3445, &timers.t3502,
+                                   &timers.t3510, &timers.t3511, &timers.t3512, &timers.t3516, &timers.t3517,
+                                   &timers.t3519, &timers.t3520, &timers.t3521, &timers.t3525, &timers.t3540,
+                                   &timers.t3584, &timers.t3585};
+
+    int nearest = INT_MAX;
+    for (auto *timer : list)
+    {
+        if (timer->isRunning())
+            nearest = std::min(nearest, timer->getRemaining());
+    }
+    return nearest;
+}
+
 namespace nr::ue
 {
 
-NasTask::NasTask(TaskBase *base) : base{base}, timers{}
+NasTask::NasTask(TaskBase *base, UeHibernationRecord *resume)
+    : base{base}, timers{resume != nullptr ? *resume->timers : UeTimers{}}, idleSince{}, hibernationRequested{},
+      isResumed{resume != nullptr}
 {
     logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "nas");
 
     mm = new NasMm(base, &timers);
     sm = new NasSm(base, &timers);
     usim = new Usim();
+
+    if (resume != nullptr)
+    {
+        delete usim;
+        usim = resume->usim.release();
+
+        mm->restoreState(*resume);
+        sm->restoreState(*resume);
+    }
+}
+
+NasTask::~NasTask()
+{
+    delete mm;
+    delete sm;
+
+    delete usim;
 }
 
 void NasTask::onStart()
 {
-    usim->initialize(base->config->supi.has_value(), base->config->initials);
+    if (!isResumed)
+        usim->initialize(base->config->getSupi().has_value(), base->config->getSubscription().initials);
 
     sm->onStart(mm);
     mm->onStart(sm, usim);
 
-    setTimer(NTS_TIMER_ID_NAS_TIMER_CYCLE, NTS_TIMER_INTERVAL_NAS_TIMER_CYCLE);
-    setTimer(NTS_TIMER_ID_MM_CYCLE, NTS_TIMER_INTERVAL_MM_CYCLE);
+    setPeriodicTimer(NTS_TIMER_ID_NAS_TIMER_CYCLE, NTS_TIMER_INTERVAL_NAS_TIMER_CYCLE);
+    setPeriodicTimer(NTS_TIMER_ID_MM_CYCLE, NTS_TIMER_INTERVAL_MM_CYCLE);
 }
 
 void NasTask::onQuit()
 {
     mm->onQuit();
     sm->onQuit();
-
-    delete mm;
-    delete sm;
-
-    delete usim;
 }
 
 void NasTask::onLoop()
@@ -101,15 +141,15 @@ void NasTask::onLoop()
         auto *w = dynamic_cast<NwTimerExpired *>(msg);
         int timerId = w->timerId;
         if (timerId == NTS_TIMER_ID_NAS_TIMER_CYCLE)
-        {
-            setTimer(NTS_TIMER_ID_NAS_TIMER_CYCLE, NTS_TIMER_INTERVAL_NAS_TIMER_CYCLE);
             performTick();
-        }
         if (timerId == NTS_TIMER_ID_MM_CYCLE)
-        {
-            setTimer(NTS_TIMER_ID_MM_CYCLE, NTS_TIMER_INTERVAL_MM_CYCLE);
             mm->handleNasEvent(NwUeNasToNas{NwUeNasToNas::PERFORM_MM_CYCLE});
-        }
+        break;
+    }
+    case NtsMessageType::UE_CLI_COMMAND: {
+        auto *w = dynamic_cast<NwUeCliCommand *>(msg);
+        UeCmdHandler handler{base};
+        handler.handleNasCmd(*w);
         break;
     }
     default:
@@ -164,6 +204,55 @@ void NasTask::performTick()
         sendExpireMsg(&timers.t3585);
 
     sm->onTimerTick();
+
+    checkHibernation();
+}
+
+bool NasTask::isIdleForHibernation() const
+{
+    return mm->isIdleForHibernation() && sm->isIdleForHibernation() &&
+           NearestTimerExpiry(timers) > HIBERNATION_TIMER_MARGIN;
+}
+
+void NasTask::checkHibernation()
+{
+    if (base->hibernator == nullptr || base->config->base->hibernateAfter <= 0)
+        return;
+
+    if (!isIdleForHibernation())
+    {
+        idleSince = 0;
+        hibernationRequested = false;
+        return;
+    }
+
+    int64_t current = utils::CurrentTimeMillis();
+    if (idleSince == 0)
+        idleSince = current;
+
+    if (!hibernationRequested && current - idleSince >= base->config->base->hibernateAfter)
+    {
+        hibernationRequested = true;
+        base->appTask->push(new NwUeNasToApp(NwUeNasToApp::HIBERNATE));
+    }
+}
+
+bool NasTask::saveState(UeHibernationRecord &record)
+{
+    bool isIdle = isIdleForHibernation();
+
+    int nearest = NearestTimerExpiry(timers);
+    record.wakeTime =
+        nearest == INT_MAX ? 0 : utils::CurrentTimeMillis() + (nearest - HIBERNATION_TIMER_MARGIN) * 1000LL;
+    record.timers = std::make_unique<UeTimers>(timers);
+
+    mm->saveState(record);
+    sm->saveState(record);
+
+    record.usim.reset(usim);
+    usim = new Usim();
+
+    return isIdle;
 }
 
 } // namespace nr::ue
\ No newline at end of file
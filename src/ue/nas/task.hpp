@@ -32,11 +32,21 @@ class NasTask : public NtsTask
     NasSm *sm;
     Usim *usim;
 
+    // Time at which the UE became idle for hibernation, zero if it is not idle
+    int64_t idleSince;
+    bool hibernationRequested;
+    bool isResumed;
+
     friend class UeCmdHandler;
 
   public:
-    explicit NasTask(TaskBase *base);
-    ~NasTask() override = default;
+    // - If a hibernation record is given, the state in it is taken over instead of starting from scratch.
+    explicit NasTask(TaskBase *base, UeHibernationRecord *resume = nullptr);
+    ~NasTask() override;
+
+    // - Moves the state to the record, called after the task is quit. Returns false if the UE is no longer idle for
+    //   hibernation, the state is moved regardless.
+    bool saveState(UeHibernationRecord &record);
 
   protected:
     void onStart() override;
@@ -45,6 +55,8 @@ class NasTask : public NtsTask
 
   private:
     void performTick();
+    void checkHibernation();
+    [[nodiscard]] bool isIdleForHibernation() const;
 };
 
 } // namespace nr::ue
\ No newline at end of file
@@ -71,7 +71,7 @@ class Usim
     bool m_isECallOnly{};
 
   public:
-    void initialize(bool hasSupi, const UeConfig::Initials &initials);
+    void initialize(bool hasSupi, const UeBaseConfig::Initials &initials);
 
     bool isValid();
     void invalidate();
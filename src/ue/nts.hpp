@@ -13,15 +13,18 @@
 #include <lib/app/cli_base.hpp>
 #include <lib/nas/timer.hpp>
 #include <lib/rrc/rrc.hpp>
+#include <lib/udp/server_task.hpp>
+#include <memory>
 #include <utility>
 #include <utils/network.hpp>
 #include <utils/nts.hpp>
 #include <utils/octet_string.hpp>
+#include <utils/packet_buffer.hpp>
 
 namespace nr::ue
 {
 
-struct NwAppToTun : NtsMessage
+struct NwAppToTun final : NtsPooledMessage<NwAppToTun, NtsMessageType::UE_APP_TO_TUN>
 {
     enum PR
     {
@@ -32,12 +35,12 @@ struct NwAppToTun : NtsMessage
     int psi{};
     OctetString data{};
 
-    explicit NwAppToTun(PR present) : NtsMessage(NtsMessageType::UE_APP_TO_TUN), present(present)
+    explicit NwAppToTun(PR present) : present(present)
     {
     }
 };
 
-struct NwUeTunToApp : NtsMessage
+struct NwUeTunToApp final : NtsPooledMessage<NwUeTunToApp, NtsMessageType::UE_TUN_TO_APP>
 {
     enum PR
     {
@@ -47,12 +50,12 @@ struct NwUeTunToApp : NtsMessage
 
     // DATA_PDU_DELIVERY
     int psi{};
-    OctetString data{};
+    std::vector<PacketBuffer> packets{}; // Packets read from the device at once, see rls::PDU_DELIVERY_HEADROOM
 
     // TUN_ERROR
     std::string error{};
 
-    explicit NwUeTunToApp(PR present) : NtsMessage(NtsMessageType::UE_TUN_TO_APP), present(present)
+    explicit NwUeTunToApp(PR present) : present(present)
     {
     }
 };
@@ -184,6 +187,7 @@ struct NwUeNasToApp : NtsMessage
     enum PR
     {
         PERFORM_SWITCH_OFF,
+        HIBERNATE,
     } present;
 
     explicit NwUeNasToApp(PR present) : NtsMessage(NtsMessageType::UE_NAS_TO_APP), present(present)
@@ -191,6 +195,17 @@ struct NwUeNasToApp : NtsMessage
     }
 };
 
+// Sent by the hibernator to the app task of a hibernated UE
+struct NwUeWakeUp : NtsMessage
+{
+    // The RLS message which caused the wake up, to be handled by the RLS task once the UE is awake
+    std::unique_ptr<udp::NwUdpServerReceive> packet{};
+
+    NwUeWakeUp() : NtsMessage(NtsMessageType::UE_WAKE_UP)
+    {
+    }
+};
+
 struct NwUeAppToNas : NtsMessage
 {
     enum PR
@@ -207,7 +222,7 @@ struct NwUeAppToNas : NtsMessage
     }
 };
 
-struct NwUeAppToRls : NtsMessage
+struct NwUeAppToRls final : NtsPooledMessage<NwUeAppToRls, NtsMessageType::UE_APP_TO_RLS>
 {
     enum PR
     {
@@ -216,14 +231,14 @@ struct NwUeAppToRls : NtsMessage
 
     // DATA_PDU_DELIVERY
     int psi{};
-    OctetString pdu{};
+    PacketBuffer pdu{};
 
-    explicit NwUeAppToRls(PR present) : NtsMessage(NtsMessageType::UE_APP_TO_RLS), present(present)
+    explicit NwUeAppToRls(PR present) : present(present)
     {
     }
 };
 
-struct NwUeRlsToApp : NtsMessage
+struct NwUeRlsToApp final : NtsPooledMessage<NwUeRlsToApp, NtsMessageType::UE_RLS_TO_APP>
 {
     enum PR
     {
@@ -234,7 +249,7 @@ struct NwUeRlsToApp : NtsMessage
     int psi{};
     OctetString pdu{};
 
-    explicit NwUeRlsToApp(PR present) : NtsMessage(NtsMessageType::UE_RLS_TO_APP), present(present)
+    explicit NwUeRlsToApp(PR present) : present(present)
     {
     }
 };
@@ -266,6 +281,13 @@ struct NwUeCliCommand : NtsMessage
     std::unique_ptr<app::UeCliCommand> cmd;
     InetAddress address;
 
+    // Parts of the STATUS output collected by the tasks that the command passes through
+    std::vector<Json> pduSessions{};
+    std::string campedCell{};
+
+    // MEMORY output collected by the tasks that the command passes through
+    UeMemoryUsage memory{};
+
     NwUeCliCommand(std::unique_ptr<app::UeCliCommand> cmd, InetAddress address)
         : NtsMessage(NtsMessageType::UE_CLI_COMMAND), cmd(std::move(cmd)), address(address)
     {
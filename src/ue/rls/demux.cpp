@@ -0,0 +1,92 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "demux.hpp"
+
+#include <algorithm>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/udp/server_task.hpp>
+
+// Limits the datagrams received at once, so that the other sockets of the reactor thread are not starved
+#define RECEIVE_BUDGET 64
+
+namespace nr::ue
+{
+
+UeRlsDemux::UeRlsDemux(int socketCount) : m_portals{}, m_mutex{}, m_tasks{}
+{
+    for (int i = 0; i < std::max(socketCount, 1); i++)
+    {
+        auto portal = std::make_unique<Portal>();
+        portal->demux = this;
+        portal->registration = udp::UdpReactor::Shared().add(portal->server.Fd(), portal.get());
+        m_portals.push_back(std::move(portal));
+    }
+}
+
+UeRlsDemux::~UeRlsDemux()
+{
+    for (auto &portal : m_portals)
+        udp::UdpReactor::Shared().remove(portal->registration);
+}
+
+void UeRlsDemux::attach(uint64_t sti, NtsTask *rlsTask)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_tasks[sti] = rlsTask;
+}
+
+void UeRlsDemux::detach(uint64_t sti)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_tasks.erase(sti);
+}
+
+void UeRlsDemux::send(uint64_t sti, const InetAddress &address, const OctetString &packet)
+{
+    send(sti, address, packet.data(), static_cast<size_t>(packet.length()));
+}
+
+void UeRlsDemux::send(uint64_t sti, const InetAddress &address, const uint8_t *buffer, size_t length)
+{
+    // A UE always uses the same socket, so that the gNB sees a stable address for it
+    auto &portal = *m_portals[sti % m_portals.size()];
+    portal.server.Send(address, buffer, length);
+}
+
+void UeRlsDemux::deliver(const uint8_t *buffer, size_t length, const InetAddress &fromAddress)
+{
+    uint64_t sti = rls::PeekTargetSti(buffer, length);
+    if (sti == 0)
+        return;
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_tasks.find(sti);
+    if (it == m_tasks.end())
+        return;
+
+    std::vector<uint8_t> v(buffer, buffer + length);
+    it->second->push(new udp::NwUdpServerReceive(OctetString{std::move(v)}, fromAddress));
+}
+
+void UeRlsDemux::Portal::onReadable(uint8_t *buffer, size_t bufferSize)
+{
+    for (int i = 0; i < RECEIVE_BUDGET; i++)
+    {
+        InetAddress peerAddress{};
+
+        int size = server.ReceiveNonBlocking(buffer, bufferSize, peerAddress);
+        if (size <= 0)
+            break;
+
+        demux->deliver(buffer, static_cast<size_t>(size), peerAddress);
+    }
+}
+
+} // namespace nr::ue
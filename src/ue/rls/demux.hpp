@@ -0,0 +1,62 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/udp/reactor.hpp>
+#include <lib/udp/server.hpp>
+#include <utils/network.hpp>
+#include <utils/nts.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::ue
+{
+
+// Shares a few RLS sockets among all UEs of the process.
+// - The RLS messages received by the sockets are routed to the RLS task of the target UE, identified by the STI.
+// - The sockets are watched by the shared UDP reactor.
+class UeRlsDemux
+{
+  private:
+    struct Portal : udp::IUdpReactorHandler
+    {
+        UeRlsDemux *demux{};
+        udp::UdpServer server{};
+        udp::UdpReactor::Registration *registration{};
+
+        void onReadable(uint8_t *buffer, size_t bufferSize) override;
+    };
+
+    std::vector<std::unique_ptr<Portal>> m_portals;
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint64_t, NtsTask *> m_tasks;
+
+  public:
+    explicit UeRlsDemux(int socketCount);
+    ~UeRlsDemux();
+
+    UeRlsDemux(const UeRlsDemux &) = delete;
+    UeRlsDemux &operator=(const UeRlsDemux &) = delete;
+
+    void attach(uint64_t sti, NtsTask *rlsTask);
+    void detach(uint64_t sti);
+
+    void send(uint64_t sti, const InetAddress &address, const OctetString &packet);
+    void send(uint64_t sti, const InetAddress &address, const uint8_t *buffer, size_t length);
+
+  private:
+    void deliver(const uint8_t *buffer, size_t length, const InetAddress &fromAddress);
+};
+
+} // namespace nr::ue
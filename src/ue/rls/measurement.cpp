@@ -38,11 +38,17 @@ void UeRlsTask::onMeasurement()
     // clear pending measurements
     m_pendingMeasurements = {};
 
-    // Issue another cell info request for each address in the search space
-    for (auto &ip : m_cellSearchSpace)
+    // Issue another cell info request for each address in the search space. In passive measurement, the beacons are
+    // measured instead, and the requests only keep the UE in the coverage of the gNBs.
+    int64_t current = utils::CurrentTimeMillis();
+    if (!m_isPassive || current - m_lastCellInfoRequest >= rls::BEACON_KEEPALIVE_PERIOD)
     {
-        rls::RlsCellInfoRequest req{m_sti};
-        sendRlsMessage(ip, req);
+        m_lastCellInfoRequest = current;
+        for (auto &ip : m_cellSearchSpace)
+        {
+            rls::RlsCellInfoRequest req{m_sti};
+            sendRlsMessage(ip, req);
+        }
     }
 
     // Send PLMN search response to the RRC if it is requested
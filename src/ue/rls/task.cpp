@@ -7,6 +7,9 @@
 //
 
 #include "task.hpp"
+#include "demux.hpp"
+#include <ue/app/cmd_handler.hpp>
+#include <ue/hibernation.hpp>
 #include <ue/nts.hpp>
 #include <utils/common.hpp>
 #include <utils/constants.hpp>
@@ -18,16 +21,19 @@ static constexpr const int TIMER_PERIOD_MEASUREMENT_MAX = 2000;
 static constexpr const int TIMER_ID_RAPID_LAUNCH = 2;
 static constexpr const int TIMER_PERIOD_RAPID_LAUNCH = 750;
 
+static constexpr const int MSG_BATCH_SIZE = 64;
+
 namespace nr::ue
 {
 
 UeRlsTask::UeRlsTask(TaskBase *base)
     : m_base{base}, m_udpTask{}, m_cellSearchSpace{}, m_pendingMeasurements{}, m_activeMeasurements{},
-      m_pendingPlmnResponse{}, m_measurementPeriod{TIMER_PERIOD_MEASUREMENT_MIN}, m_servingCell{}
+      m_pendingPlmnResponse{}, m_measurementPeriod{TIMER_PERIOD_MEASUREMENT_MIN}, m_measurementTimer{}, m_isPassive{},
+      m_lastCellInfoRequest{}, m_servingCell{}, m_publishedRoute{}
 {
     m_logger = m_base->logBase->makeUniqueLogger(m_base->config->getLoggerPrefix() + "rls");
 
-    for (auto &addr : m_base->config->gnbSearchList)
+    for (auto &addr : m_base->config->base->gnbSearchList)
         m_cellSearchSpace.emplace_back(addr, cons::PortalPort);
 
     m_sti = utils::Random64();
@@ -35,25 +41,38 @@ UeRlsTask::UeRlsTask(TaskBase *base)
 
 void UeRlsTask::onStart()
 {
-    m_udpTask = new udp::UdpServerTask(this);
-
     std::vector<InetAddress> gnbSearchList{};
-    for (auto &ip : m_base->config->gnbSearchList)
+    for (auto &ip : m_base->config->base->gnbSearchList)
         gnbSearchList.emplace_back(ip, cons::PortalPort);
 
-    m_udpTask->start();
+    if (m_base->rlsDemux != nullptr)
+    {
+        m_base->rlsDemux->attach(m_sti, this);
+    }
+    else
+    {
+        m_udpTask = new udp::UdpServerTask(this);
+        m_udpTask->start();
+    }
 
-    setTimer(TIMER_ID_MEASUREMENT, m_measurementPeriod);
+    m_measurementTimer = setPeriodicTimer(TIMER_ID_MEASUREMENT, m_measurementPeriod);
     setTimer(TIMER_ID_RAPID_LAUNCH, TIMER_PERIOD_RAPID_LAUNCH);
     onMeasurement();
 }
 
 void UeRlsTask::onLoop()
 {
-    NtsMessage *msg = take();
-    if (!msg)
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
         return;
 
+    for (NtsMessage *msg : m_msgBatch)
+        handleMessage(msg);
+
+    publishUplinkRoute();
+}
+
+void UeRlsTask::handleMessage(NtsMessage *msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::UE_RRC_TO_RLS: {
@@ -77,11 +96,11 @@ void UeRlsTask::onLoop()
         break;
     }
     case NtsMessageType::UE_APP_TO_RLS: {
-        auto *w = dynamic_cast<NwUeAppToRls *>(msg);
+        auto *w = NtsCast<NwUeAppToRls>(msg);
         switch (w->present)
         {
         case NwUeAppToRls::DATA_PDU_DELIVERY: {
-            deliverUplinkPdu(rls::EPduType::DATA, std::move(w->pdu), OctetString::FromOctet4(static_cast<int>(w->psi)));
+            deliverUplinkData(w->psi, std::move(w->pdu));
             break;
         }
         }
@@ -90,10 +109,7 @@ void UeRlsTask::onLoop()
     case NtsMessageType::TIMER_EXPIRED: {
         auto *w = dynamic_cast<NwTimerExpired *>(msg);
         if (w->timerId == TIMER_ID_MEASUREMENT)
-        {
-            setTimer(TIMER_ID_MEASUREMENT, m_measurementPeriod);
             onMeasurement();
-        }
         else if (w->timerId == TIMER_ID_RAPID_LAUNCH)
         {
             slowDownMeasurements();
@@ -101,7 +117,7 @@ void UeRlsTask::onLoop()
         break;
     }
     case NtsMessageType::UDP_SERVER_RECEIVE: {
-        auto *w = dynamic_cast<udp::NwUdpServerReceive *>(msg);
+        auto *w = NtsCast<udp::NwUdpServerReceive>(msg);
         auto rlsMsg = rls::DecodeRlsMessage(OctetView{w->packet});
         if (rlsMsg == nullptr)
         {
@@ -111,6 +127,12 @@ void UeRlsTask::onLoop()
         receiveRlsMessage(w->fromAddress, *rlsMsg);
         break;
     }
+    case NtsMessageType::UE_CLI_COMMAND: {
+        auto *w = dynamic_cast<NwUeCliCommand *>(msg);
+        UeCmdHandler handler{m_base};
+        handler.handleRlsCmd(*w);
+        break;
+    }
     default:
         m_logger->unhandledNts(msg);
         break;
@@ -121,13 +143,52 @@ void UeRlsTask::onLoop()
 
 void UeRlsTask::onQuit()
 {
-    m_udpTask->quit();
+    // The socket is not released until the TUN receivers stop using it
+    m_base->uplinkFastPath->clearRoute();
+
+    if (m_base->rlsDemux != nullptr)
+        m_base->rlsDemux->detach(m_sti);
+
+    if (m_udpTask != nullptr)
+        m_udpTask->quit();
     delete m_udpTask;
 }
 
+void UeRlsTask::saveState(UeHibernationRecord &record) const
+{
+    record.sti = m_sti;
+    record.servingCell = m_servingCell;
+}
+
+void UeRlsTask::restoreState(const UeHibernationRecord &record)
+{
+    m_sti = record.sti;
+    m_servingCell = record.servingCell;
+    slowDownMeasurements();
+
+    // The hibernator has seen the serving cell recently, it is assumed to be measured so that its loss is detected
+    // as usual if it does not respond anymore
+    if (m_servingCell.has_value())
+    {
+        UeCellMeasurement meas{};
+        meas.sti = m_servingCell->sti;
+        meas.cellId = m_servingCell->cellId;
+        meas.tac = m_servingCell->tac;
+        meas.gnbName = m_servingCell->gnbName;
+        meas.linkIp = m_servingCell->linkIp;
+
+        m_pendingMeasurements[meas.cellId] = meas;
+    }
+}
+
 void UeRlsTask::slowDownMeasurements()
 {
     m_measurementPeriod = TIMER_PERIOD_MEASUREMENT_MAX;
+    cancelTimer(m_measurementTimer);
+    m_measurementTimer = setPeriodicTimer(TIMER_ID_MEASUREMENT, m_measurementPeriod);
+
+    // The cells are polled rapidly until the UE is launched, and their beacons are listened to afterwards
+    m_isPassive = m_base->config->base->passiveMeasurement;
 }
 
 } // namespace nr::ue
@@ -15,6 +15,7 @@
 #include <optional>
 #include <thread>
 #include <ue/types.hpp>
+#include <ue/uplink.hpp>
 #include <unordered_map>
 #include <utils/common_types.hpp>
 #include <utils/logger.hpp>
@@ -36,9 +37,14 @@ class UeRlsTask : public NtsTask
     std::unordered_map<GlobalNci, UeCellMeasurement> m_activeMeasurements;
     bool m_pendingPlmnResponse;
     int64_t m_measurementPeriod;
+    NtsTimerHandle m_measurementTimer;
+    bool m_isPassive;
+    int64_t m_lastCellInfoRequest;
 
     uint64_t m_sti;
     std::optional<UeCellInfo> m_servingCell;
+    std::optional<std::pair<uint64_t, std::string>> m_publishedRoute; // STI and link IP of the uplink route
+    std::vector<NtsMessage *> m_msgBatch{};
 
     friend class UeCmdHandler;
 
@@ -46,18 +52,29 @@ class UeRlsTask : public NtsTask
     explicit UeRlsTask(TaskBase *base);
     ~UeRlsTask() override = default;
 
+    // - Called after the task is quit
+    void saveState(UeHibernationRecord &record) const;
+    // - Called before the task is started
+    void restoreState(const UeHibernationRecord &record);
+
   protected:
     void onStart() override;
     void onLoop() override;
     void onQuit() override;
 
+  private:
+    void handleMessage(NtsMessage *msg);
+
   private: /* Base */
     void slowDownMeasurements();
 
   private: /* Transport */
     void receiveRlsMessage(const InetAddress &address, rls::RlsMessage &msg);
     void sendRlsMessage(const InetAddress &address, const rls::RlsMessage &msg);
+    void sendRlsPacket(const InetAddress &address, const uint8_t *buffer, size_t length);
     void deliverUplinkPdu(rls::EPduType pduType, OctetString &&pdu, OctetString &&payload);
+    void deliverUplinkData(int psi, PacketBuffer &&pdu);
+    void publishUplinkRoute();
     void deliverDownlinkPdu(rls::RlsPduDelivery &msg);
 
   private: /* Measurement */
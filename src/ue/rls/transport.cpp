@@ -7,6 +7,7 @@
 //
 
 #include "task.hpp"
+#include "demux.hpp"
 #include <ue/app/task.hpp>
 #include <ue/nts.hpp>
 #include <ue/rrc/task.hpp>
@@ -37,7 +38,15 @@ void UeRlsTask::sendRlsMessage(const InetAddress &address, const rls::RlsMessage
 {
     OctetString stream{};
     rls::EncodeRlsMessage(msg, stream);
-    m_udpTask->send(address, stream);
+    sendRlsPacket(address, stream.data(), static_cast<size_t>(stream.length()));
+}
+
+void UeRlsTask::sendRlsPacket(const InetAddress &address, const uint8_t *buffer, size_t length)
+{
+    if (m_base->rlsDemux != nullptr)
+        m_base->rlsDemux->send(m_sti, address, buffer, length);
+    else
+        m_udpTask->send(address, buffer, length);
 }
 
 void UeRlsTask::deliverUplinkPdu(rls::EPduType pduType, OctetString &&pdu, OctetString &&payload)
@@ -55,6 +64,44 @@ void UeRlsTask::deliverUplinkPdu(rls::EPduType pduType, OctetString &&pdu, Octet
     sendRlsMessage(InetAddress{m_servingCell->linkIp, cons::PortalPort}, msg);
 }
 
+void UeRlsTask::deliverUplinkData(int psi, PacketBuffer &&pdu)
+{
+    if (!m_servingCell.has_value())
+    {
+        m_logger->warn("RLS uplink delivery requested without a serving cell");
+        return;
+    }
+
+    // The RLS header is written into the headroom reserved by the TUN receiver, the packet is not copied
+    rls::EncodeRlsPduDelivery(m_sti, rls::EPduType::DATA, OctetString::FromOctet4(psi), pdu);
+    sendRlsPacket(InetAddress{m_servingCell->linkIp, cons::PortalPort}, pdu.data(), pdu.length());
+}
+
+void UeRlsTask::publishUplinkRoute()
+{
+    std::optional<std::pair<uint64_t, std::string>> current{};
+    if (m_servingCell.has_value())
+        current = std::make_pair(m_sti, m_servingCell->linkIp);
+
+    if (current == m_publishedRoute)
+        return;
+
+    if (current.has_value())
+    {
+        UeUplinkRoute route{};
+        route.sti = m_sti;
+        route.address = InetAddress{m_servingCell->linkIp, cons::PortalPort};
+        route.demux = m_base->rlsDemux;
+        route.udpTask = m_udpTask;
+        m_base->uplinkFastPath->setRoute(route);
+    }
+    else
+    {
+        m_base->uplinkFastPath->clearRoute();
+    }
+    m_publishedRoute = std::move(current);
+}
+
 void UeRlsTask::deliverDownlinkPdu(rls::RlsPduDelivery &msg)
 {
     if (msg.pduType == rls::EPduType::RRC)
@@ -69,7 +116,7 @@ void UeRlsTask::deliverDownlinkPdu(rls::RlsPduDelivery &msg)
         auto *nw = new NwUeRlsToApp(NwUeRlsToApp::DATA_PDU_DELIVERY);
         nw->psi = msg.payload.get4I(0);
         nw->pdu = std::move(msg.pdu);
-        m_base->appTask->push(nw);
+        m_base->appTask->push(nw, NtsLane::BULK);
     }
 }
 
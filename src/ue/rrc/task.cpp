@@ -12,6 +12,7 @@
 #include <asn/rrc/ASN_RRC_ULInformationTransfer-IEs.h>
 #include <asn/rrc/ASN_RRC_ULInformationTransfer.h>
 #include <lib/rrc/encode.hpp>
+#include <ue/app/cmd_handler.hpp>
 #include <ue/app/task.hpp>
 #include <ue/nas/task.hpp>
 #include <ue/rls/task.hpp>
@@ -76,6 +77,12 @@ void UeRrcTask::onLoop()
         }
         break;
     }
+    case NtsMessageType::UE_CLI_COMMAND: {
+        auto *w = dynamic_cast<NwUeCliCommand *>(msg);
+        UeCmdHandler handler{m_base};
+        handler.handleRrcCmd(*w);
+        break;
+    }
     case NtsMessageType::UE_RLS_TO_RRC: {
         auto *w = dynamic_cast<NwUeRlsToRrc *>(msg);
         switch (w->present)
@@ -0,0 +1,496 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "subscribers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utils/common.hpp>
+#include <utils/libc_error.hpp>
+
+#define BINARY_MAGIC "UESUBTB1"
+#define BINARY_MAGIC_SIZE 8
+#define HEADER_SIZE 64
+#define SUPI_SIZE 16
+#define RECORD_SIZE 256
+#define RECORD_ALIGNMENT 4096
+
+#define MAX_SLICES 8
+#define MAX_SESSIONS 4
+#define MAX_APN_LENGTH 31
+#define SLICE_SIZE 5
+#define SESSION_SIZE 39
+#define NOT_GIVEN 0xFF
+
+#define SESSION_EMERGENCY 0x01
+#define SESSION_HAS_SLICE 0x02
+#define SESSION_HAS_APN 0x04
+
+/* Record layout, a slice is {hasSd, sst, sd[3]} and a session is {type, flags, slice[5], apnLength, apn[31]} */
+#define REC_KEY 0
+#define REC_OP 16
+#define REC_AMF 32
+#define REC_OP_TYPE 34
+#define REC_SLICE_COUNT 35
+#define REC_SLICES 36
+#define REC_SESSION_COUNT (REC_SLICES + MAX_SLICES * SLICE_SIZE)
+#define REC_SESSIONS (REC_SESSION_COUNT + 1)
+
+static_assert(REC_SESSIONS + MAX_SESSIONS * SESSION_SIZE <= RECORD_SIZE);
+
+namespace nr::ue
+{
+
+static uint64_t ReadLe(const uint8_t *data, int size)
+{
+    uint64_t res = 0;
+    for (int i = size - 1; i >= 0; i--)
+        res = (res << 8) | data[i];
+    return res;
+}
+
+static void WriteLe(uint8_t *data, uint64_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+        data[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+static size_t RecordOffset(size_t count)
+{
+    size_t end = HEADER_SIZE + count * SUPI_SIZE;
+    return (end + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+static std::vector<std::string> Split(const std::string &value, char delimiter)
+{
+    std::vector<std::string> res{};
+    std::stringstream ss{value};
+    std::string item;
+    while (std::getline(ss, item, delimiter))
+    {
+        utils::Trim(item);
+        res.push_back(std::move(item));
+    }
+    return res;
+}
+
+static OctetString ParseHex(const std::string &field, const std::string &value, size_t length)
+{
+    if (value.size() != length * 2 || !std::all_of(value.begin(), value.end(), ::isxdigit))
+        throw std::runtime_error("invalid " + field + " value: " + value);
+    return OctetString::FromHex(value);
+}
+
+static int ParseInteger(const std::string &field, const std::string &value, int max)
+{
+    try
+    {
+        size_t pos = 0;
+        long res = std::stol(value, &pos, 0);
+        if (pos == value.size() && res >= 0 && res <= max)
+            return static_cast<int>(res);
+    }
+    catch (const std::logic_error &)
+    {
+    }
+    throw std::runtime_error("invalid " + field + " value: " + value);
+}
+
+static Supi ParseSupi(std::string value)
+{
+    utils::Trim(value);
+    if (value.find('-') == std::string::npos)
+        value = "imsi-" + value;
+    return Supi::Parse(value);
+}
+
+static SingleSlice ParseSlice(const std::string &value)
+{
+    SingleSlice res{};
+    size_t colon = value.find(':');
+    res.sst = ParseInteger("sst", value.substr(0, colon), 0xFF);
+    if (colon != std::string::npos)
+        res.sd = octet3{ParseInteger("sd", value.substr(colon + 1), 0xFFFFFF)};
+    return res;
+}
+
+static nas::EPduSessionType ParseSessionType(const std::string &type)
+{
+    if (type == "IPv4")
+        return nas::EPduSessionType::IPV4;
+    if (type == "IPv6")
+        return nas::EPduSessionType::IPV6;
+    if (type == "IPv4v6")
+        return nas::EPduSessionType::IPV4V6;
+    if (type == "Ethernet")
+        return nas::EPduSessionType::ETHERNET;
+    if (type == "Unstructured")
+        return nas::EPduSessionType::UNSTRUCTURED;
+    throw std::runtime_error("invalid PDU session type: " + type);
+}
+
+static SessionConfig ParseSession(const std::string &value)
+{
+    auto parts = Split(value, '/');
+    if (parts.empty() || parts.size() > 3)
+        throw std::runtime_error("invalid session value: " + value);
+
+    SessionConfig res{};
+    res.type = ParseSessionType(parts[0]);
+    if (parts.size() > 1 && !parts[1].empty())
+        res.apn = parts[1];
+    if (parts.size() > 2 && !parts[2].empty())
+        res.sNssai = ParseSlice(parts[2]);
+    return res;
+}
+
+static SubscriberRecord ParseCsvRow(const std::string &line)
+{
+    auto fields = Split(line, ',');
+    if (fields.size() < 5 || fields.size() > 7)
+        throw std::runtime_error("invalid number of columns");
+
+    SubscriberRecord res{};
+    (void)ParseSupi(fields[0]);
+    res.key = ParseHex("key", fields[1], 16);
+    res.opC = ParseHex("op", fields[2], 16);
+    if (fields[3] == "OP")
+        res.opType = OpType::OP;
+    else if (fields[3] == "OPC")
+        res.opType = OpType::OPC;
+    else
+        throw std::runtime_error("invalid OP type: " + fields[3]);
+    res.amf = ParseHex("amf", fields[4], 2);
+
+    if (fields.size() > 5 && !fields[5].empty())
+    {
+        res.slices = std::vector<SingleSlice>{};
+        for (auto &item : Split(fields[5], ';'))
+            if (!item.empty())
+                res.slices->push_back(ParseSlice(item));
+    }
+    if (fields.size() > 6 && !fields[6].empty())
+    {
+        res.sessions = std::vector<SessionConfig>{};
+        for (auto &item : Split(fields[6], ';'))
+            if (!item.empty())
+                res.sessions->push_back(ParseSession(item));
+    }
+    return res;
+}
+
+static void WriteSlice(uint8_t *data, const SingleSlice &slice)
+{
+    data[0] = slice.sd.has_value() ? 1 : 0;
+    data[1] = static_cast<uint8_t>(slice.sst);
+    WriteLe(data + 2, slice.sd.has_value() ? static_cast<uint32_t>(static_cast<int32_t>(*slice.sd)) : 0, 3);
+}
+
+static SingleSlice ReadSlice(const uint8_t *data)
+{
+    SingleSlice res{};
+    res.sst = data[1];
+    if (data[0])
+        res.sd = octet3{static_cast<uint32_t>(ReadLe(data + 2, 3))};
+    return res;
+}
+
+static void WriteRecord(uint8_t *data, const SubscriberRecord &record)
+{
+    if (record.slices.has_value() && record.slices->size() > MAX_SLICES)
+        throw std::runtime_error("too many slices for the binary format");
+    if (record.sessions.has_value() && record.sessions->size() > MAX_SESSIONS)
+        throw std::runtime_error("too many sessions for the binary format");
+
+    std::memcpy(data + REC_KEY, record.key.data(), 16);
+    std::memcpy(data + REC_OP, record.opC.data(), 16);
+    std::memcpy(data + REC_AMF, record.amf.data(), 2);
+    data[REC_OP_TYPE] = static_cast<uint8_t>(record.opType);
+
+    data[REC_SLICE_COUNT] = NOT_GIVEN;
+    if (record.slices.has_value())
+    {
+        data[REC_SLICE_COUNT] = static_cast<uint8_t>(record.slices->size());
+        for (size_t i = 0; i < record.slices->size(); i++)
+            WriteSlice(data + REC_SLICES + i * SLICE_SIZE, (*record.slices)[i]);
+    }
+
+    data[REC_SESSION_COUNT] = NOT_GIVEN;
+    if (record.sessions.has_value())
+    {
+        data[REC_SESSION_COUNT] = static_cast<uint8_t>(record.sessions->size());
+        for (size_t i = 0; i < record.sessions->size(); i++)
+        {
+            auto &sess = (*record.sessions)[i];
+            uint8_t *p = data + REC_SESSIONS + i * SESSION_SIZE;
+
+            if (sess.apn.has_value() && sess.apn->size() > MAX_APN_LENGTH)
+                throw std::runtime_error("APN is too long for the binary format: " + *sess.apn);
+
+            p[0] = static_cast<uint8_t>(sess.type);
+            p[1] = (sess.isEmergency ? SESSION_EMERGENCY : 0) | (sess.sNssai.has_value() ? SESSION_HAS_SLICE : 0) |
+                   (sess.apn.has_value() ? SESSION_HAS_APN : 0);
+            if (sess.sNssai.has_value())
+                WriteSlice(p + 2, *sess.sNssai);
+            if (sess.apn.has_value())
+            {
+                p[7] = static_cast<uint8_t>(sess.apn->size());
+                std::memcpy(p + 8, sess.apn->data(), sess.apn->size());
+            }
+        }
+    }
+}
+
+static SubscriberRecord ReadRecord(const uint8_t *data)
+{
+    SubscriberRecord res{};
+    res.key = OctetString{std::vector<uint8_t>{data + REC_KEY, data + REC_KEY + 16}};
+    res.opC = OctetString{std::vector<uint8_t>{data + REC_OP, data + REC_OP + 16}};
+    res.amf = OctetString{std::vector<uint8_t>{data + REC_AMF, data + REC_AMF + 2}};
+    res.opType = data[REC_OP_TYPE] == static_cast<uint8_t>(OpType::OPC) ? OpType::OPC : OpType::OP;
+
+    if (data[REC_SLICE_COUNT] != NOT_GIVEN)
+    {
+        res.slices = std::vector<SingleSlice>{};
+        for (int i = 0; i < std::min<int>(data[REC_SLICE_COUNT], MAX_SLICES); i++)
+            res.slices->push_back(ReadSlice(data + REC_SLICES + i * SLICE_SIZE));
+    }
+
+    if (data[REC_SESSION_COUNT] != NOT_GIVEN)
+    {
+        res.sessions = std::vector<SessionConfig>{};
+        for (int i = 0; i < std::min<int>(data[REC_SESSION_COUNT], MAX_SESSIONS); i++)
+        {
+            const uint8_t *p = data + REC_SESSIONS + i * SESSION_SIZE;
+
+            SessionConfig sess{};
+            sess.type = static_cast<nas::EPduSessionType>(p[0]);
+            sess.isEmergency = p[1] & SESSION_EMERGENCY;
+            if (p[1] & SESSION_HAS_SLICE)
+                sess.sNssai = ReadSlice(p + 2);
+            if (p[1] & SESSION_HAS_APN)
+                sess.apn = std::string(reinterpret_cast<const char *>(p + 8), std::min<size_t>(p[7], MAX_APN_LENGTH));
+            res.sessions->push_back(std::move(sess));
+        }
+    }
+    return res;
+}
+
+SubscriberTable::SubscriberTable(const std::string &path)
+    : m_path{path}, m_data{}, m_size{}, m_format{}, m_count{}, m_recordOffset{}, m_mutex{}, m_rows{}, m_scanOffset{},
+      m_headerChecked{}
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw LibError("Subscriber table could not be opened: " + path + ": ", errno);
+
+    struct stat st = {};
+    if (::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw LibError("Subscriber table could not be opened: " + path + ": ", err);
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            throw LibError("Subscriber table could not be mapped: " + path + ": ", err);
+        }
+        m_data = reinterpret_cast<const char *>(data);
+    }
+    ::close(fd);
+
+    if (m_size < HEADER_SIZE || std::memcmp(m_data, BINARY_MAGIC, BINARY_MAGIC_SIZE) != 0)
+    {
+        m_format = EFormat::CSV;
+        ::madvise(const_cast<char *>(m_data), m_size, MADV_SEQUENTIAL);
+        return;
+    }
+
+    m_format = EFormat::BINARY;
+
+    auto *header = reinterpret_cast<const uint8_t *>(m_data);
+    if (ReadLe(header + 8, 4) != RECORD_SIZE || ReadLe(header + 12, 4) != SUPI_SIZE)
+        throw std::runtime_error("Subscriber table has an unsupported binary format: " + path);
+
+    m_count = static_cast<size_t>(ReadLe(header + 16, 8));
+    m_recordOffset = RecordOffset(m_count);
+    if (m_count > (m_size - HEADER_SIZE) / SUPI_SIZE || m_recordOffset + m_count * RECORD_SIZE > m_size)
+        throw std::runtime_error("Subscriber table is truncated: " + path);
+
+    // Rows are accessed by the UE index, read-ahead would only page in the rows of the other UEs
+    ::madvise(const_cast<char *>(m_data), m_size, MADV_RANDOM);
+}
+
+SubscriberTable::~SubscriberTable()
+{
+    if (m_data != nullptr)
+        ::munmap(const_cast<char *>(m_data), m_size);
+}
+
+size_t SubscriberTable::size() const
+{
+    if (m_format == EFormat::BINARY)
+        return m_count;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    scanCsv(SIZE_MAX);
+    return m_rows.size();
+}
+
+void SubscriberTable::scanCsv(size_t row) const
+{
+    while (m_rows.size() <= row && m_scanOffset < m_size)
+    {
+        size_t start = m_scanOffset;
+        auto *newLine = reinterpret_cast<const char *>(std::memchr(m_data + start, '\n', m_size - start));
+        size_t end = newLine != nullptr ? static_cast<size_t>(newLine - m_data) : m_size;
+        m_scanOffset = end + 1;
+
+        size_t first = start;
+        while (first < end && (m_data[first] == ' ' || m_data[first] == '\t' || m_data[first] == '\r'))
+            first++;
+        if (first == end || m_data[first] == '#')
+            continue;
+
+        if (!m_headerChecked)
+        {
+            m_headerChecked = true;
+            if (end - first >= 4 && std::memcmp(m_data + first, "supi", 4) == 0 &&
+                (end - first == 4 || m_data[first + 4] == ',' || m_data[first + 4] == ' '))
+                continue;
+        }
+
+        m_rows.push_back(start);
+    }
+}
+
+std::string SubscriberTable::csvLine(size_t row) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    scanCsv(row);
+
+    if (m_rows.size() <= row)
+        throw std::runtime_error("Subscriber table has no row for UE " + std::to_string(row) + ": " + m_path);
+
+    size_t start = m_rows[row];
+    lock.unlock();
+
+    auto *newLine = reinterpret_cast<const char *>(std::memchr(m_data + start, '\n', m_size - start));
+    size_t end = newLine != nullptr ? static_cast<size_t>(newLine - m_data) : m_size;
+    return std::string(m_data + start, end - start);
+}
+
+const uint8_t *SubscriberTable::binaryRecord(size_t row) const
+{
+    if (row >= m_count)
+        throw std::runtime_error("Subscriber table has no row for UE " + std::to_string(row) + ": " + m_path);
+    return reinterpret_cast<const uint8_t *>(m_data + m_recordOffset + row * RECORD_SIZE);
+}
+
+Supi SubscriberTable::getSupi(size_t row) const
+{
+    if (m_format == EFormat::BINARY)
+    {
+        (void)binaryRecord(row);
+        const char *supi = m_data + HEADER_SIZE + row * SUPI_SIZE;
+        return Supi{"imsi", std::string(supi, strnlen(supi, SUPI_SIZE))};
+    }
+
+    std::string line = csvLine(row);
+    try
+    {
+        return ParseSupi(line.substr(0, line.find(',')));
+    }
+    catch (const std::runtime_error &e)
+    {
+        throw std::runtime_error("Subscriber table row " + std::to_string(row) + " is invalid: " + e.what());
+    }
+}
+
+SubscriberRecord SubscriberTable::read(size_t row) const
+{
+    if (m_format == EFormat::BINARY)
+        return ReadRecord(binaryRecord(row));
+
+    std::string line = csvLine(row);
+    try
+    {
+        return ParseCsvRow(line);
+    }
+    catch (const std::runtime_error &e)
+    {
+        throw std::runtime_error("Subscriber table row " + std::to_string(row) + " is invalid: " + e.what());
+    }
+}
+
+void SubscriberTable::WriteBinary(const SubscriberTable &table, const std::string &path)
+{
+    size_t count = table.size();
+
+    std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+    if (!stream)
+        throw std::runtime_error("Subscriber table could not be written: " + path);
+
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    WriteLe(header + 8, RECORD_SIZE, 4);
+    WriteLe(header + 12, SUPI_SIZE, 4);
+    WriteLe(header + 16, count, 8);
+    stream.write(reinterpret_cast<const char *>(header), HEADER_SIZE);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Supi supi = table.getSupi(i);
+        if (supi.type != "imsi" || supi.value.size() > SUPI_SIZE)
+            throw std::runtime_error("SUPI is not supported by the binary format: " + ToJson(supi).str());
+
+        char buffer[SUPI_SIZE] = {};
+        std::memcpy(buffer, supi.value.data(), supi.value.size());
+        stream.write(buffer, SUPI_SIZE);
+    }
+
+    std::vector<char> padding(RecordOffset(count) - (HEADER_SIZE + count * SUPI_SIZE));
+    stream.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto record = table.read(i);
+        uint8_t data[RECORD_SIZE] = {};
+        try
+        {
+            WriteRecord(data, record);
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw std::runtime_error("Subscriber table row " + std::to_string(i) + " is invalid: " + e.what());
+        }
+        stream.write(reinterpret_cast<const char *>(data), RECORD_SIZE);
+    }
+
+    stream.flush();
+    if (!stream)
+        throw std::runtime_error("Subscriber table could not be written: " + path);
+}
+
+} // namespace nr::ue
@@ -0,0 +1,89 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "types.hpp"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <utils/common_types.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::ue
+{
+
+// Subscription data in a single row of the subscriber table, the SUPI is read separately.
+// - The slices and sessions are optional, the ones in the base configuration are used if they are not given.
+struct SubscriberRecord
+{
+    OctetString key{};
+    OctetString opC{};
+    OpType opType{};
+    OctetString amf{};
+    std::optional<std::vector<SingleSlice>> slices{};
+    std::optional<std::vector<SessionConfig>> sessions{};
+};
+
+// Subscription data of a large UE population, the row i belongs to the UE with index i.
+// - The file is memory mapped and a row is parsed only when it is read, so that only the touched rows are paged in.
+// - A CSV file has the columns "supi,key,op,opType,amf[,slices[,sessions]]". Slices are given as "sst[:sd];...",
+//   and sessions as "type[/apn[/sst[:sd]]];...". Empty lines, comments (#) and a header line are skipped.
+// - A binary file holds the SUPIs in a contiguous column followed by fixed-size records, hence listing the SUPIs
+//   touches only a small part of the file and any row is found without scanning. See WriteBinary.
+// - Throws std::runtime_error for unreadable files and malformed rows.
+class SubscriberTable
+{
+  private:
+    enum class EFormat
+    {
+        CSV,
+        BINARY
+    };
+
+    std::string m_path;
+    const char *m_data;
+    size_t m_size;
+    EFormat m_format;
+
+    /* BINARY */
+    size_t m_count;
+    size_t m_recordOffset;
+
+    /* CSV, start offsets of the rows found so far */
+    mutable std::mutex m_mutex;
+    mutable std::vector<size_t> m_rows;
+    mutable size_t m_scanOffset;
+    mutable bool m_headerChecked;
+
+  public:
+    explicit SubscriberTable(const std::string &path);
+    ~SubscriberTable();
+
+    SubscriberTable(const SubscriberTable &) = delete;
+    SubscriberTable &operator=(const SubscriberTable &) = delete;
+
+    // Number of rows, a CSV file is scanned until the end for this
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] Supi getSupi(size_t row) const;
+    [[nodiscard]] SubscriberRecord read(size_t row) const;
+
+    // Writes the table in the binary format
+    static void WriteBinary(const SubscriberTable &table, const std::string &path);
+
+  private:
+    // Finds the CSV rows until the given one, m_mutex must be held
+    void scanCsv(size_t row) const;
+    [[nodiscard]] std::string csvLine(size_t row) const;
+    [[nodiscard]] const uint8_t *binaryRecord(size_t row) const;
+};
+
+} // namespace nr::ue
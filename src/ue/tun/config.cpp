@@ -109,6 +109,27 @@ static const char *NextInterfaceName(const std::string &prefix)
     return nullptr;
 }
 
+static void TunSetUp(const char *ifName, int mtu)
+{
+    ifreq ifr{};
+    strncpy(ifr.ifr_name, ifName, IFNAMSIZ - 1);
+
+    int sockFd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (ioctl(sockFd, SIOCGIFFLAGS, &ifr) < 0)
+        throw LibError("ioctl(SIOCGIFFLAGS)", errno);
+
+    ifr.ifr_mtu = mtu;
+    if (ioctl(sockFd, SIOCSIFMTU, &ifr) < 0)
+        throw LibError("ioctl(SIOCSIFMTU)", errno);
+
+    ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
+    if (ioctl(sockFd, SIOCSIFFLAGS, &ifr) < 0)
+        throw LibError("ioctl(SIOCSIFFLAGS)", errno);
+
+    close(sockFd);
+}
+
 static void TunSetIpAndUp(const char *ifName, const char *ipAddr, int mtu)
 {
     ifreq ifr{};
@@ -134,18 +155,10 @@ static void TunSetIpAndUp(const char *ifName, const char *ipAddr, int mtu)
 
     if (ioctl(sockFd, SIOCSIFADDR, &ifr) < 0)
         throw LibError("ioctl(SIOCSIFADDR)", errno);
-    if (ioctl(sockFd, SIOCGIFFLAGS, &ifr) < 0)
-        throw LibError("ioctl(SIOCGIFFLAGS)", errno);
-
-    ifr.ifr_mtu = mtu;
-    if (ioctl(sockFd, SIOCSIFMTU, &ifr) < 0)
-        throw LibError("ioctl(SIOCSIFMTU)", errno);
-
-    ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
-    if (ioctl(sockFd, SIOCSIFFLAGS, &ifr) < 0)
-        throw LibError("ioctl(SIOCSIFFLAGS)", errno);
 
     close(sockFd);
+
+    TunSetUp(ifName, mtu);
 }
 
 static void ConfigureRtTables(const std::string &table_name)
@@ -312,42 +325,71 @@ static void AddIpRoutes(const std::string &if_name, const std::string &table_nam
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName)
+// Returns -1 and leaves errno set on failure
+static int OpenTunQueue(const char *tunName, short flags)
 {
-    // acquire the configuration lock
-    const std::lock_guard<std::mutex> lock(configMutex);
-
-    const char *ifName = NextInterfaceName(ifPrefix);
-    if (!ifName)
-        throw LibError("TUN interface name could not be allocated.", errno);
-
-    char tunName[IFNAMSIZ];
-    strcpy(tunName, ifName);
+    int fd;
+    if ((fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
+        return -1;
 
     ifreq ifr{};
-    int fd;
+    ifr.ifr_flags = flags;
+    strncpy(ifr.ifr_name, tunName, IFNAMSIZ);
 
-    if ((fd = open("/dev/net/tun", O_RDWR)) < 0)
-        throw LibError("Open failure /dev/net/tun");
+    if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0 || strcmp(ifr.ifr_name, tunName) != 0)
+    {
+        int errNo = errno;
+        close(fd);
+        errno = errNo;
+        return -1;
+    }
+
+    return fd;
+}
 
-    memset(&ifr, 0, sizeof(ifr));
+void AllocateTun(const char *ifPrefix, char **allocatedName, int queueCount, int *fds)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
 
-    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    // Each queue of a multi-queue interface is attached by opening the device again with the same name
+    short flags = IFF_TUN | IFF_NO_PI;
+    if (queueCount > 1)
+        flags |= IFF_MULTI_QUEUE;
 
-    strncpy(ifr.ifr_name, tunName, IFNAMSIZ);
+    char tunName[IFNAMSIZ];
 
-    if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0)
+    // The first queue creates the interface exclusively, the name is taken again if another process takes it first
+    for (int attempt = 0;; attempt++)
     {
-        close(fd);
-        throw LibError("ioctl(TUNSETIFF)", errno);
+        const char *ifName = NextInterfaceName(ifPrefix);
+        if (!ifName)
+            throw LibError("TUN interface name could not be allocated.", errno);
+
+        strncpy(tunName, ifName, IFNAMSIZ - 1);
+        tunName[IFNAMSIZ - 1] = '\0';
+        free((void *)ifName);
+
+        fds[0] = OpenTunQueue(tunName, static_cast<short>(flags | IFF_TUN_EXCL));
+        if (fds[0] >= 0)
+            break;
+        if (errno != EBUSY || attempt + 1 >= MAX_INTERFACE_COUNT)
+            throw LibError("TUN interface could not be allocated", errno);
     }
 
-    strcpy(tunName, ifr.ifr_name);
-    if (strcmp(tunName, ifName) != 0)
-        throw LibError("TUN interface name could not be allocated.");
+    for (int i = 1; i < queueCount; i++)
+    {
+        fds[i] = OpenTunQueue(tunName, flags);
+        if (fds[i] < 0)
+        {
+            int errNo = errno;
+            for (int j = 0; j < i; j++)
+                close(fds[j]);
+            throw LibError("TUN queue could not be attached", errNo);
+        }
+    }
 
     *allocatedName = strdup(tunName);
-    return fd;
 }
 
 void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute)
@@ -368,4 +410,43 @@ void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configu
     }
 }
 
+void ConfigureSharedTun(const char *tunName, int mtu, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    TunSetUp(tunName, mtu);
+    if (configureRoute)
+    {
+        std::string table_name = ROUTING_TABLE_PREFIX + std::string(tunName);
+
+        ConfigureRtTables(table_name);
+        RemoveExistingIpRoutes(tunName, table_name);
+        AddIpRoutes(tunName, table_name);
+    }
+}
+
+void AddTunAddress(const char *tunName, const char *ipAddr, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    ExecStrict("ip addr replace " + std::string(ipAddr) + "/32 dev " + tunName);
+    if (configureRoute)
+    {
+        RemoveExistingIpRules(ipAddr);
+        AddNewIpRules(ipAddr, ROUTING_TABLE_PREFIX + std::string(tunName));
+    }
+}
+
+void RemoveTunAddress(const char *tunName, const char *ipAddr, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    if (configureRoute)
+        RemoveExistingIpRules(ipAddr);
+    ExecStrict("ip addr del " + std::string(ipAddr) + "/32 dev " + tunName);
+}
+
 } // namespace nr::ue::tun
@@ -15,7 +15,15 @@
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName);
+// Allocates a TUN interface with the given number of queues, the non-blocking file descriptors of the queues are
+// written into fds.
+void AllocateTun(const char *ifPrefix, char **allocatedName, int queueCount, int *fds);
 void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute);
 
+// A shared interface is brought up without an address, and the addresses of the UEs are added and removed one by
+// one. With routing, the traffic of each address is routed to the interface by a rule to its single routing table.
+void ConfigureSharedTun(const char *tunName, int mtu, bool configureRoute);
+void AddTunAddress(const char *tunName, const char *ipAddr, bool configureRoute);
+void RemoveTunAddress(const char *tunName, const char *ipAddr, bool configureRoute);
+
 } // namespace nr::ue::tun
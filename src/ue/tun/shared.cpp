@@ -0,0 +1,275 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "shared.hpp"
+#include "config.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <ue/nts.hpp>
+#include <ue/uplink.hpp>
+#include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+
+// The MTU of the interface is configured as well, larger packets are not read from the device
+#define RECEIVER_BUFFER_SIZE cons::TunMtu
+#define RECEIVER_BATCH_SIZE 32
+#define IPV4_HEADER_SIZE 20
+
+namespace nr::ue
+{
+
+struct ReceiverArgs
+{
+    UeSharedTun *tun{};
+    int index{};
+};
+
+UeSharedTun::UeSharedTun(int queueCount, bool configureRouting)
+    : m_name{}, m_fds{}, m_configureRouting{configureRouting}, m_receivers{},
+      m_logger{LogBase::Shared()->makeUniqueLogger("tun")}, m_mutex{}, m_bindings{},
+      m_epochs{new std::atomic<uint64_t>[static_cast<size_t>(queueCount)]{}}
+{
+    char *name = nullptr;
+    m_fds.resize(static_cast<size_t>(queueCount));
+    tun::AllocateTun(cons::TunNamePrefix, &name, queueCount, m_fds.data());
+    m_name = name;
+    free(name);
+
+    tun::ConfigureSharedTun(m_name.c_str(), cons::TunMtu, configureRouting);
+
+    for (int i = 0; i < queueCount; i++)
+    {
+        auto *args = new ReceiverArgs{this, i};
+        m_receivers.push_back(new ScopedThread(
+            [](void *arg) {
+                auto *receiverArgs = reinterpret_cast<ReceiverArgs *>(arg);
+                UeSharedTun *tun = receiverArgs->tun;
+                int receiverIndex = receiverArgs->index;
+                delete receiverArgs;
+                tun->receive(receiverIndex);
+            },
+            args));
+    }
+}
+
+UeSharedTun::~UeSharedTun()
+{
+    for (auto *receiver : m_receivers)
+        delete receiver;
+    for (int fd : m_fds)
+        ::close(fd);
+}
+
+const std::string &UeSharedTun::name() const
+{
+    return m_name;
+}
+
+bool UeSharedTun::attach(const std::string &address, int psi, NtsTask *appTask, UeUplinkFastPath *fastPath,
+                         std::string &error)
+{
+    in_addr addr{};
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1)
+    {
+        error = "Invalid IPv4 address";
+        return false;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_bindings.find(addr.s_addr);
+        if (it != m_bindings.end() && (it->second.appTask != appTask || it->second.psi != psi))
+        {
+            error = "Address is already used by another PDU session";
+            return false;
+        }
+        m_bindings[addr.s_addr] = Binding{appTask, psi, fastPath};
+    }
+
+    try
+    {
+        tun::AddTunAddress(m_name.c_str(), address.c_str(), m_configureRouting);
+    }
+    catch (const LibError &e)
+    {
+        error = e.what();
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_bindings.erase(addr.s_addr);
+        return false;
+    }
+
+    return true;
+}
+
+void UeSharedTun::detach(const std::string &address)
+{
+    in_addr addr{};
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1)
+        return;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        if (m_bindings.erase(addr.s_addr) == 0)
+            return;
+    }
+
+    // Waits for the deliveries which may have looked up the binding before it is erased. The pushes do not block, so
+    // this does not wait for the task calling detach().
+    for (size_t i = 0; i < m_fds.size(); i++)
+    {
+        uint64_t epoch = m_epochs[i].load();
+        while ((epoch & 1) != 0 && m_epochs[i].load() == epoch)
+            std::this_thread::yield();
+    }
+
+    try
+    {
+        tun::RemoveTunAddress(m_name.c_str(), address.c_str(), m_configureRouting);
+    }
+    catch (const LibError &e)
+    {
+        m_logger->warn("Address[%s] could not be removed from TUN interface[%s] [%s]", address.c_str(),
+                       m_name.c_str(), e.what());
+    }
+}
+
+bool UeSharedTun::write(const OctetString &packet, std::string &error)
+{
+    // The packets of a UE are always written to the same queue, so that they are not reordered
+    uint32_t destination = 0;
+    if (packet.length() >= IPV4_HEADER_SIZE)
+        std::memcpy(&destination, packet.data() + 16, sizeof(destination));
+    int fd = m_fds[destination % m_fds.size()];
+
+    ssize_t res = ::write(fd, packet.data(), static_cast<size_t>(packet.length()));
+    if (res < 0)
+    {
+        error = "TUN device could not write (" + std::string{strerror(errno)} + ")";
+        return false;
+    }
+    if (res != packet.length())
+    {
+        error = "TUN device partially written";
+        return false;
+    }
+    return true;
+}
+
+void UeSharedTun::receive(int index)
+{
+    int fd = m_fds[index];
+
+    // A slow UE must not stall the other UEs on the same queue
+    NtsTask::MarkNonBlockingThread();
+
+    std::vector<PacketBuffer> packets{};
+    PacketBuffer buffer{};
+    pollfd pfd{fd, POLLIN, 0};
+
+    while (true)
+    {
+        if (::poll(&pfd, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            m_logger->err("TUN interface[%s] could not be polled [%s]", m_name.c_str(), strerror(errno));
+            return; // Abort receiver thread
+        }
+
+        // The packets are read until the queue is drained, and delivered together
+        while (packets.size() < RECEIVER_BATCH_SIZE)
+        {
+            // The packets are read after a headroom, so that they are sent without copying by the RLS tasks
+            if (buffer.isNull())
+                buffer = PacketBuffer::Allocate(rls::PDU_DELIVERY_HEADROOM,
+                                                RECEIVER_BUFFER_SIZE + rls::PDU_DELIVERY_TAILROOM);
+            buffer.resize(RECEIVER_BUFFER_SIZE);
+
+            ssize_t n = ::read(fd, buffer.data(), buffer.length());
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                m_logger->err("TUN interface[%s] could not read [%s]", m_name.c_str(), strerror(errno));
+                return; // Abort receiver thread
+            }
+            if (n == 0)
+                break;
+
+            buffer.resize(static_cast<size_t>(n));
+            packets.push_back(std::move(buffer));
+        }
+
+        deliver(index, packets);
+        packets.clear();
+    }
+}
+
+void UeSharedTun::deliver(int index, std::vector<PacketBuffer> &packets)
+{
+    // The packets of the same PDU session are delivered together if they cannot be sent directly
+    std::vector<std::pair<NtsTask *, NwUeTunToApp *>> messages{};
+
+    // The messages are pushed after the lock is released, the epoch keeps their tasks alive meanwhile
+    auto &epoch = m_epochs[index];
+    epoch++;
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    for (auto &packet : packets)
+    {
+        // Only IPv4 sessions are supported, the other packets of the kernel (e.g. IPv6 solicitations) are dropped
+        if (packet.length() < IPV4_HEADER_SIZE || (packet.data()[0] >> 4) != 4)
+            continue;
+
+        uint32_t source = 0;
+        std::memcpy(&source, packet.data() + 12, sizeof(source));
+
+        auto it = m_bindings.find(source);
+        if (it == m_bindings.end())
+            continue;
+
+        auto &binding = it->second;
+        auto route = binding.fastPath->acquire(binding.psi);
+        if (route != nullptr)
+        {
+            UeUplinkFastPath::Send(*route, binding.psi, packet);
+            continue;
+        }
+
+        auto entry = std::find_if(messages.begin(), messages.end(), [&binding](auto &item) {
+            return item.first == binding.appTask && item.second->psi == binding.psi;
+        });
+        if (entry == messages.end())
+        {
+            auto *nw = new NwUeTunToApp(NwUeTunToApp::DATA_PDU_DELIVERY);
+            nw->psi = binding.psi;
+            messages.emplace_back(binding.appTask, nw);
+            entry = messages.end() - 1;
+        }
+        entry->second->packets.push_back(std::move(packet));
+    }
+
+    lock.unlock();
+    for (auto &item : messages)
+        item.first->push(item.second, NtsLane::BULK);
+    epoch++;
+}
+
+} // namespace nr::ue
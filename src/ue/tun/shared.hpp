@@ -0,0 +1,80 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/logger.hpp>
+#include <utils/nts.hpp>
+#include <utils/octet_string.hpp>
+#include <utils/packet_buffer.hpp>
+#include <utils/scoped_thread.hpp>
+
+namespace nr::ue
+{
+
+class UeUplinkFastPath;
+
+// Shares a single (multi-queue) TUN interface among all UEs of the process.
+// - The PDU addresses of the UEs are assigned to the interface, and the uplink packets are routed to the app task of
+//   the UE by their source address.
+// - Each queue of the interface is read by a separate receiver thread, the downlink packets are written by the app
+//   tasks directly.
+// - The uplink packets of the connected sessions are sent by the receivers directly, see UeUplinkFastPath.
+class UeSharedTun
+{
+  private:
+    struct Binding
+    {
+        NtsTask *appTask{};
+        int psi{};
+        UeUplinkFastPath *fastPath{};
+    };
+
+    std::string m_name;
+    std::vector<int> m_fds;
+    bool m_configureRouting;
+    std::vector<ScopedThread *> m_receivers;
+    std::unique_ptr<Logger> m_logger;
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint32_t, Binding> m_bindings; // By IPv4 address in network byte order
+    // Odd while the receiver of the same index delivers the packets looked up in m_bindings, see detach()
+    std::unique_ptr<std::atomic<uint64_t>[]> m_epochs;
+
+  public:
+    // Throws std::runtime_error if the interface cannot be allocated
+    UeSharedTun(int queueCount, bool configureRouting);
+    ~UeSharedTun();
+
+    UeSharedTun(const UeSharedTun &) = delete;
+    UeSharedTun &operator=(const UeSharedTun &) = delete;
+
+    [[nodiscard]] const std::string &name() const;
+
+    // Assigns the address to the interface and routes the uplink packets from it to the given task
+    bool attach(const std::string &address, int psi, NtsTask *appTask, UeUplinkFastPath *fastPath,
+                std::string &error);
+    // No packet is delivered to the task of the address after this returns
+    void detach(const std::string &address);
+
+    bool write(const OctetString &packet, std::string &error);
+
+  private:
+    void receive(int index);
+    void deliver(int index, std::vector<PacketBuffer> &packets);
+};
+
+} // namespace nr::ue
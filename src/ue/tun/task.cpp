@@ -7,21 +7,29 @@
 //
 
 #include "task.hpp"
+#include <cerrno>
 #include <cstring>
+#include <poll.h>
+#include <lib/rls/rls_pdu.hpp>
 #include <ue/app/task.hpp>
 #include <ue/nts.hpp>
+#include <ue/uplink.hpp>
 #include <unistd.h>
+#include <utils/constants.hpp>
 #include <utils/libc_error.hpp>
 #include <utils/scoped_thread.hpp>
 
-// TODO: May be reduced to MTU 1500
-#define RECEIVER_BUFFER_SIZE 16000
+// The MTU of the interface is configured by TunConfigure, larger packets are not read from the device
+#define RECEIVER_BUFFER_SIZE cons::TunMtu
+#define RECEIVER_BATCH_SIZE 32
+#define MSG_BATCH_SIZE 64
 
 struct ReceiverArgs
 {
     int fd{};
     int psi{};
     NtsTask *targetTask{};
+    nr::ue::UeUplinkFastPath *fastPath{};
 };
 
 static std::string GetErrorMessage(const std::string &cause)
@@ -47,64 +55,125 @@ static void ReceiverThread(ReceiverArgs *args)
     int fd = args->fd;
     int psi = args->psi;
     NtsTask *targetTask = args->targetTask;
+    nr::ue::UeUplinkFastPath *fastPath = args->fastPath;
 
     delete args;
 
-    uint8_t buffer[RECEIVER_BUFFER_SIZE];
+    // The app task may wait for this thread while releasing the session
+    NtsTask::MarkNonBlockingThread();
+
+    PacketBuffer buffer{};
+    pollfd pfd{fd, POLLIN, 0};
 
     while (true)
     {
-        int n = ::read(fd, buffer, RECEIVER_BUFFER_SIZE);
-        if (n < 0)
+        if (::poll(&pfd, 1, -1) < 0)
         {
-            targetTask->push(NwError(GetErrorMessage("TUN device could not read")));
+            if (errno == EINTR)
+                continue;
+            targetTask->push(NwError(GetErrorMessage("TUN device could not be polled")));
             return; // Abort receiver thread
         }
 
-        if (n > 0)
+        // The packets are read until the queue is drained, and sent directly if the session is open. Otherwise they
+        // are delivered together through the tasks.
+        auto route = fastPath->acquire(psi);
+        auto *nw = new nr::ue::NwUeTunToApp(nr::ue::NwUeTunToApp::DATA_PDU_DELIVERY);
+        nw->psi = psi;
+        size_t count = 0;
+
+        while (count < RECEIVER_BATCH_SIZE)
         {
-            auto *nw = new nr::ue::NwUeTunToApp(nr::ue::NwUeTunToApp::DATA_PDU_DELIVERY);
-            nw->psi = psi;
-            nw->data = OctetString::FromArray(buffer, static_cast<size_t>(n));
-            targetTask->push(nw);
+            // The packets are read after a headroom, so that they are sent without copying by the RLS task
+            if (buffer.isNull())
+                buffer = PacketBuffer::Allocate(rls::PDU_DELIVERY_HEADROOM,
+                                                RECEIVER_BUFFER_SIZE + rls::PDU_DELIVERY_TAILROOM);
+            buffer.resize(RECEIVER_BUFFER_SIZE);
+
+            ssize_t n = ::read(fd, buffer.data(), buffer.length());
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                targetTask->push(NwError(GetErrorMessage("TUN device could not read")));
+                delete nw;
+                return; // Abort receiver thread
+            }
+            if (n == 0)
+                break;
+
+            buffer.resize(static_cast<size_t>(n));
+            count++;
+
+            if (route != nullptr)
+            {
+                nr::ue::UeUplinkFastPath::Send(*route, psi, buffer);
+                buffer = PacketBuffer{};
+            }
+            else
+            {
+                nw->packets.push_back(std::move(buffer));
+            }
         }
+
+        if (nw->packets.empty())
+            delete nw;
+        else
+            targetTask->push(nw, NtsLane::BULK);
     }
 }
 
 namespace nr::ue
 {
 
-ue::TunTask::TunTask(TaskBase *base, int psi, int fd) : m_base{base}, m_psi{psi}, m_fd{fd}, m_receiver{}
+ue::TunTask::TunTask(TaskBase *base, int psi, std::vector<int> fds)
+    : m_base{base}, m_psi{psi}, m_fds{std::move(fds)}, m_receivers{}
 {
 }
 
 void TunTask::onStart()
 {
-    auto *receiverArgs = new ReceiverArgs();
-    receiverArgs->fd = m_fd;
-    receiverArgs->targetTask = this;
-    receiverArgs->psi = m_psi;
-    m_receiver =
-        new ScopedThread([](void *args) { ReceiverThread(reinterpret_cast<ReceiverArgs *>(args)); }, receiverArgs);
+    for (int fd : m_fds)
+    {
+        auto *receiverArgs = new ReceiverArgs();
+        receiverArgs->fd = fd;
+        receiverArgs->targetTask = this;
+        receiverArgs->psi = m_psi;
+        receiverArgs->fastPath = m_base->uplinkFastPath;
+        m_receivers.push_back(new ScopedThread(
+            [](void *args) { ReceiverThread(reinterpret_cast<ReceiverArgs *>(args)); }, receiverArgs));
+    }
 }
 
 void TunTask::onQuit()
 {
-    delete m_receiver;
-    ::close(m_fd);
+    for (auto *receiver : m_receivers)
+        delete receiver;
+    m_receivers.clear();
+
+    for (int fd : m_fds)
+        ::close(fd);
 }
 
 void TunTask::onLoop()
 {
-    NtsMessage *msg = take();
-    if (!msg)
+    if (takeBatch(m_msgBatch, MSG_BATCH_SIZE) == 0)
         return;
 
+    for (NtsMessage *msg : m_msgBatch)
+        handleMessage(msg);
+}
+
+void TunTask::handleMessage(NtsMessage *msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::UE_APP_TO_TUN: {
-        auto *w = dynamic_cast<NwAppToTun *>(msg);
-        int res = ::write(m_fd, w->data.data(), w->data.length());
+        // The kernel takes a single packet per write on any queue, the downlink packets are written to the first one
+        auto *w = NtsCast<NwAppToTun>(msg);
+        int res = ::write(m_fds[0], w->data.data(), w->data.length());
         if (res < 0)
             push(NwError(GetErrorMessage("TUN device could not write")));
         else if (res != w->data.length())
@@ -113,7 +182,8 @@ void TunTask::onLoop()
         break;
     }
     case NtsMessageType::UE_TUN_TO_APP: {
-        m_base->appTask->push(msg);
+        auto *w = NtsCast<NwUeTunToApp>(msg);
+        m_base->appTask->push(w, w->present == NwUeTunToApp::DATA_PDU_DELIVERY ? NtsLane::BULK : NtsLane::CONTROL);
         break;
     }
     default:
@@ -25,19 +25,24 @@ class TunTask : public NtsTask
   private:
     TaskBase *m_base;
     int m_psi;
-    int m_fd;
-    ScopedThread *m_receiver;
+    std::vector<int> m_fds;
+    std::vector<ScopedThread *> m_receivers;
+    std::vector<NtsMessage *> m_msgBatch{};
 
     friend class UeCmdHandler;
 
   public:
-    explicit TunTask(TaskBase *taskBase, int psi, int fd);
+    // Each queue of the interface is read by a separate receiver thread
+    explicit TunTask(TaskBase *taskBase, int psi, std::vector<int> fds);
     ~TunTask() override = default;
 
   protected:
     void onStart() override;
     void onLoop() override;
     void onQuit() override;
+
+  private:
+    void handleMessage(NtsMessage *msg);
 };
 
 } // namespace nr::ue
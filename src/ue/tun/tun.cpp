@@ -8,28 +8,34 @@
 
 #include "tun.hpp"
 #include "config.hpp"
+
+#include <cstdlib>
+
 #include <utils/libc_error.hpp>
 
 namespace nr::ue::tun
 {
 
-int TunAllocate(const char *namePrefix, std::string &allocatedName, std::string &error)
+bool TunAllocate(const char *namePrefix, int queueCount, std::string &allocatedName, std::vector<int> &fds,
+                 std::string &error)
 {
-    int fd;
     char *name = nullptr;
+    fds.resize(static_cast<size_t>(queueCount));
     try
     {
-        fd = tun::AllocateTun(namePrefix, &name);
+        tun::AllocateTun(namePrefix, &name, queueCount, fds.data());
         allocatedName = std::string{name};
+        free(name);
     }
     catch (const LibError &e)
     {
         error = e.what();
         allocatedName = "";
-        return 0;
+        fds.clear();
+        return false;
     }
 
-    return fd;
+    return true;
 }
 
 bool TunConfigure(const std::string &tunName, const std::string &ipAddress, int mtu, bool configureRouting, std::string &error)
@@ -7,8 +7,12 @@
 //
 
 #include "types.hpp"
+#include "subscribers.hpp"
+#include <utils/memory.hpp>
 #include <utils/printer.hpp>
 
+#include <stdexcept>
+
 namespace nr::ue
 {
 
@@ -122,13 +126,106 @@ Json ToJson(const EMmSubState &state)
 Json ToJson(const UeConfig &v)
 {
     return Json::Obj({
-        {"supi", ToJson(v.supi)},
-        {"hplmn", ToJson(v.hplmn)},
-        {"imei", ::ToJson(v.imei)},
-        {"imeiSv", ::ToJson(v.imeiSv)},
+        {"supi", ToJson(v.getSupi())},
+        {"hplmn", ToJson(v.base->hplmn)},
+        {"imei", ::ToJson(v.getImei())},
+        {"imeiSv", ::ToJson(v.getImeiSv())},
     });
 }
 
+// Adds the offset to a decimal identity, keeping its number of digits
+static std::string OffsetIdentity(const std::string &value, int offset)
+{
+    if (offset == 0)
+        return value;
+
+    for (char c : value)
+        if (c < '0' || c > '9')
+            throw std::runtime_error("UE identity is not numeric: " + value);
+
+    // Identities are at most 16 digits, which always fits into 64 bits
+    uint64_t number = std::stoull(value) + static_cast<uint64_t>(offset);
+
+    std::string res = std::to_string(number);
+    if (res.size() > value.size())
+        throw std::runtime_error("UE serial number overflow");
+    return std::string(value.size() - res.size(), '0') + res;
+}
+
+std::optional<Supi> UeConfig::getSupi() const
+{
+    if (base->subscribers != nullptr)
+        return base->subscribers->getSupi(static_cast<size_t>(index));
+    if (!base->supi.has_value())
+        return std::nullopt;
+    return Supi{base->supi->type, OffsetIdentity(base->supi->value, index)};
+}
+
+std::optional<std::string> UeConfig::getImei() const
+{
+    if (!base->imei.has_value())
+        return std::nullopt;
+    return OffsetIdentity(*base->imei, index);
+}
+
+std::optional<std::string> UeConfig::getImeiSv() const
+{
+    if (!base->imeiSv.has_value())
+        return std::nullopt;
+    return OffsetIdentity(*base->imeiSv, index);
+}
+
+UeSubscription UeConfig::getSubscription() const
+{
+    UeSubscription res{};
+
+    if (base->subscribers == nullptr)
+    {
+        res.key = base->key.copy();
+        res.opC = base->opC.copy();
+        res.opType = base->opType;
+        res.amf = base->amf.copy();
+        res.initials = base->initials;
+        res.sessions = base->initSessions;
+        return res;
+    }
+
+    auto record = base->subscribers->read(static_cast<size_t>(index));
+    res.key = std::move(record.key);
+    res.opC = std::move(record.opC);
+    res.opType = record.opType;
+    res.amf = std::move(record.amf);
+    res.initials = base->initials;
+    if (record.slices.has_value())
+        res.initials.configuredNssai.slices = std::move(*record.slices);
+    res.sessions = record.sessions.has_value() ? std::move(*record.sessions) : base->initSessions;
+    return res;
+}
+
+std::string UeConfig::getNodeName() const
+{
+    if (base->supi.has_value() || base->subscribers != nullptr)
+        return ToJson(getSupi()).str();
+    if (base->imei.has_value())
+        return "imei-" + *getImei();
+    if (base->imeiSv.has_value())
+        return "imeisv-" + *getImeiSv();
+    return "unknown-ue";
+}
+
+std::string UeConfig::getLoggerPrefix() const
+{
+    if (!base->prefixLogger)
+        return "";
+    if (base->supi.has_value() || base->subscribers != nullptr)
+        return getSupi()->value + "|";
+    if (base->imei.has_value())
+        return *getImei() + "|";
+    if (base->imeiSv.has_value())
+        return *getImeiSv() + "|";
+    return "unknown-ue|";
+}
+
 Json ToJson(const UeTimers &v)
 {
     return Json::Obj({
@@ -274,4 +371,40 @@ Json ToJson(const EServiceReqCause &v)
     }
 }
 
+size_t UeMemoryUsage::total() const
+{
+    return config + app + nas + rrc + rls + tun + loggers + hibernation;
+}
+
+UeMemoryUsage &UeMemoryUsage::operator+=(const UeMemoryUsage &other)
+{
+    config += other.config;
+    app += other.app;
+    nas += other.nas;
+    rrc += other.rrc;
+    rls += other.rls;
+    tun += other.tun;
+    loggers += other.loggers;
+    hibernation += other.hibernation;
+    threads += other.threads;
+    return *this;
+}
+
+Json ToJson(const UeMemoryUsage &v)
+{
+    return Json::Obj({
+        {"config", static_cast<int64_t>(v.config)},
+        {"app", static_cast<int64_t>(v.app)},
+        {"nas", static_cast<int64_t>(v.nas)},
+        {"rrc", static_cast<int64_t>(v.rrc)},
+        {"rls", static_cast<int64_t>(v.rls)},
+        {"tun", static_cast<int64_t>(v.tun)},
+        {"loggers", static_cast<int64_t>(v.loggers)},
+        {"hibernation", static_cast<int64_t>(v.hibernation)},
+        {"total", static_cast<int64_t>(v.total())},
+        {"threads", v.threads},
+        {"thread-stacks", static_cast<int64_t>(v.threads * utils::DefaultThreadStackSize())},
+    });
+}
+
 } // namespace nr::ue
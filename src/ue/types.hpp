@@ -27,7 +27,13 @@ class UeAppTask;
 class NasTask;
 class UeRrcTask;
 class UeRlsTask;
+class UeRlsDemux;
+class UeHibernator;
+class UeSharedTun;
+class UeUplinkFastPath;
+struct UeHibernationRecord;
 class UserEquipment;
+class SubscriberTable;
 
 struct SupportedAlgs
 {
@@ -59,7 +65,8 @@ struct IntegrityMaxDataRateConfig
     bool downlinkFull{};
 };
 
-struct UeConfig
+// Configuration shared by all UEs of the process, must not be modified once the UEs are created.
+struct UeBaseConfig
 {
     /* Read from config file */
     std::optional<Supi> supi{};
@@ -74,6 +81,10 @@ struct UeConfig
     std::vector<std::string> gnbSearchList{};
     std::vector<SessionConfig> initSessions{};
     IntegrityMaxDataRateConfig integrityMaxRate{};
+    size_t queueCapacity{};
+    NtsOverflowPolicy queuePolicy{};
+    int tunQueues{}; // Number of the TUN queues of each PDU session, or of the shared TUN interface
+    bool passiveMeasurement{}; // Listen to the cell info beacons of the gNBs instead of polling them
 
     /* Read from config file as well, but should be stored in non-volatile
      * mobile storage and subject to change in runtime */
@@ -84,32 +95,45 @@ struct UeConfig
     } initials{};
 
     /* Assigned by program */
+    const SubscriberTable *subscribers{}; // Overrides the subscription data of each UE if given
+    int64_t hibernateAfter{};             // ms in idle before hibernation, zero if disabled
     bool configureRouting{};
     bool prefixLogger{};
+};
 
-    [[nodiscard]] std::string getNodeName() const
-    {
-        if (supi.has_value())
-            return ToJson(supi).str();
-        if (imei.has_value())
-            return "imei-" + *imei;
-        if (imeiSv.has_value())
-            return "imeisv-" + *imeiSv;
-        return "unknown-ue";
-    }
+// Subscription data of a single UE
+struct UeSubscription
+{
+    OctetString key{};
+    OctetString opC{};
+    OpType opType{};
+    OctetString amf{};
+    UeBaseConfig::Initials initials{};
+    std::vector<SessionConfig> sessions{};
+};
 
-    [[nodiscard]] std::string getLoggerPrefix() const
+// Configuration of a single UE.
+// - Everything except the identities and the subscription data is read from the shared base configuration.
+// - The identities are generated from the ones in the base configuration, incremented by the UE index.
+// - If a subscriber table is given, the SUPI and the subscription data are read from the row of the UE instead.
+struct UeConfig
+{
+    const UeBaseConfig *base{};
+    int index{};
+
+    UeConfig(const UeBaseConfig *base, int index) : base(base), index(index)
     {
-        if (!prefixLogger)
-            return "";
-        if (supi.has_value())
-            return supi->value + "|";
-        if (imei.has_value())
-            return *imei + "|";
-        if (imeiSv.has_value())
-            return *imeiSv + "|";
-        return "unknown-ue|";
     }
+
+    // Throws std::runtime_error if an identity overflows its number of digits
+    [[nodiscard]] std::optional<Supi> getSupi() const;
+    [[nodiscard]] std::optional<std::string> getImei() const;
+    [[nodiscard]] std::optional<std::string> getImeiSv() const;
+    // Throws std::runtime_error if the row of the UE in the subscriber table is invalid
+    [[nodiscard]] UeSubscription getSubscription() const;
+
+    [[nodiscard]] std::string getNodeName() const;
+    [[nodiscard]] std::string getLoggerPrefix() const;
 };
 
 struct TaskBase
@@ -120,6 +144,11 @@ struct TaskBase
     app::IUeController *ueController{};
     app::INodeListener *nodeListener{};
     NtsTask *cliCallbackTask{};
+    NtsExecutor *executor{};
+    UeRlsDemux *rlsDemux{};
+    UeHibernator *hibernator{};
+    UeSharedTun *sharedTun{};
+    UeUplinkFastPath *uplinkFastPath{};
 
     UeAppTask *appTask{};
     NasTask *nasTask{};
@@ -479,6 +508,26 @@ enum class EServiceReqCause
     FALLBACK_INDICATION
 };
 
+// Estimated memory held by a UE, by component in bytes. The estimates cover the objects and the heap memory owned by
+// them, excluding the allocator overhead, the queued messages and the state shared by all UEs of the process.
+struct UeMemoryUsage
+{
+    size_t config{};
+    size_t app{};
+    size_t nas{};
+    size_t rrc{};
+    size_t rls{};
+    size_t tun{};
+    size_t loggers{};
+    size_t hibernation{};
+
+    // Dedicated threads of the UE, their stacks are reserved but mostly not resident, hence not in the total
+    int threads{};
+
+    [[nodiscard]] size_t total() const;
+    UeMemoryUsage &operator+=(const UeMemoryUsage &other);
+};
+
 Json ToJson(const ECmState &state);
 Json ToJson(const ERmState &state);
 Json ToJson(const EMmState &state);
@@ -490,5 +539,6 @@ Json ToJson(const ERegUpdateCause &v);
 Json ToJson(const EPsState &v);
 Json ToJson(const UePduSessionInfo &v);
 Json ToJson(const EServiceReqCause &v);
+Json ToJson(const UeMemoryUsage &v);
 
 } // namespace nr::ue
@@ -8,56 +8,77 @@
 
 #include "ue.hpp"
 
+#include "app/cmd_handler.hpp"
 #include "app/task.hpp"
+#include "hibernation.hpp"
 #include "nas/task.hpp"
 #include "rrc/task.hpp"
 #include "rls/task.hpp"
+#include "uplink.hpp"
+
+#include <ue/nas/usim/usim.hpp>
 
 namespace nr::ue
 {
 
 UserEquipment::UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                             NtsTask *cliCallbackTask)
+                             NtsTask *cliCallbackTask, NtsExecutor *executor, UeRlsDemux *rlsDemux,
+                             UeHibernator *hibernator, UeSharedTun *sharedTun)
+    : hibernation{}
 {
     auto *base = new TaskBase();
     base->ue = this;
     base->config = config;
-    base->logBase = new LogBase("logs/ue-" + config->getNodeName() + ".log");
+    base->logBase = LogBase::Shared();
     base->ueController = ueController;
     base->nodeListener = nodeListener;
     base->cliCallbackTask = cliCallbackTask;
+    base->executor = executor;
+    base->rlsDemux = rlsDemux;
+    base->hibernator = hibernator;
+    base->sharedTun = sharedTun;
+    base->uplinkFastPath = new UeUplinkFastPath();
 
-    base->nasTask = new NasTask(base);
-    base->rrcTask = new UeRrcTask(base);
     base->appTask = new UeAppTask(base);
-    base->rlsTask = new UeRlsTask(base);
+
+    // Bound the mailboxes of the data plane tasks
+    base->appTask->setQueueCapacity(config->base->queueCapacity, config->base->queuePolicy);
 
     taskBase = base;
+    createTasks(nullptr);
 }
 
 UserEquipment::~UserEquipment()
 {
-    taskBase->nasTask->quit();
-    taskBase->rrcTask->quit();
-    taskBase->rlsTask->quit();
+    // The app task is quit first, since it tears the other tasks down and recreates them while hibernating
     taskBase->appTask->quit();
 
+    if (hibernation != nullptr)
+    {
+        taskBase->hibernator->remove(hibernation->sti);
+    }
+    else
+    {
+        taskBase->nasTask->quit();
+        taskBase->rrcTask->quit();
+        taskBase->rlsTask->quit();
+    }
+
     delete taskBase->nasTask;
     delete taskBase->rrcTask;
     delete taskBase->rlsTask;
     delete taskBase->appTask;
 
-    delete taskBase->logBase;
-
+    delete taskBase->uplinkFastPath;
     delete taskBase;
 }
 
 void UserEquipment::start()
 {
-    taskBase->nasTask->start();
-    taskBase->rrcTask->start();
-    taskBase->rlsTask->start();
-    taskBase->appTask->start();
+    taskBase->nasTask->start(taskBase->executor);
+    taskBase->rrcTask->start(taskBase->executor);
+    taskBase->rlsTask->start(taskBase->executor);
+    taskBase->appTask->start(taskBase->executor);
 }
 
 void UserEquipment::pushCommand(std::unique_ptr<app::UeCliCommand> cmd, const InetAddress &address)
@@ -65,4 +86,108 @@ void UserEquipment::pushCommand(std::unique_ptr<app::UeCliCommand> cmd, const In
     taskBase->appTask->push(new NwUeCliCommand(std::move(cmd), address));
 }
 
+const UeConfig &UserEquipment::getConfig() const
+{
+    return *taskBase->config;
+}
+
+void UserEquipment::createTasks(UeHibernationRecord *resume)
+{
+    taskBase->nasTask = new NasTask(taskBase, resume);
+    taskBase->rrcTask = new UeRrcTask(taskBase);
+    taskBase->rlsTask = new UeRlsTask(taskBase);
+
+    if (resume != nullptr)
+        taskBase->rlsTask->restoreState(*resume);
+
+    taskBase->rlsTask->setQueueCapacity(taskBase->config->base->queueCapacity, taskBase->config->base->queuePolicy);
+}
+
+void UserEquipment::hibernate()
+{
+    if (hibernation != nullptr || taskBase->hibernator == nullptr)
+        return;
+
+    // Called on an executor worker by the app task. quit() takes the tasks out of the run queues instead of waiting for
+    // them to be run, so this does not wait on the worker itself even with a single thread.
+    taskBase->nasTask->quit();
+    taskBase->rrcTask->quit();
+    taskBase->rlsTask->quit();
+
+    hibernation = std::make_unique<UeHibernationRecord>();
+    bool isIdle = taskBase->nasTask->saveState(*hibernation);
+    taskBase->rlsTask->saveState(*hibernation);
+
+    delete taskBase->nasTask;
+    delete taskBase->rrcTask;
+    delete taskBase->rlsTask;
+
+    taskBase->nasTask = nullptr;
+    taskBase->rrcTask = nullptr;
+    taskBase->rlsTask = nullptr;
+
+    // The UE may have left the idle state after the hibernation is requested
+    if (!isIdle)
+    {
+        wake();
+        return;
+    }
+
+    taskBase->hibernator->add(hibernation->sti, taskBase->appTask, *hibernation);
+}
+
+void UserEquipment::wake()
+{
+    if (hibernation == nullptr)
+        return;
+
+    taskBase->hibernator->remove(hibernation->sti);
+
+    createTasks(hibernation.get());
+    hibernation = nullptr;
+
+    taskBase->nasTask->start(taskBase->executor);
+    taskBase->rrcTask->start(taskBase->executor);
+    taskBase->rlsTask->start(taskBase->executor);
+}
+
+bool UserEquipment::isHibernated() const
+{
+    return hibernation != nullptr;
+}
+
+UeMemoryUsage UserEquipment::estimateMemoryUsage() const
+{
+    UeMemoryUsage usage{};
+    UeCmdHandler handler{taskBase};
+    handler.addAppMemoryUsage(usage);
+    if (hibernation == nullptr)
+    {
+        handler.addRrcMemoryUsage(usage);
+        handler.addRlsMemoryUsage(usage);
+        handler.addNasMemoryUsage(usage);
+    }
+    return usage;
+}
+
+void UserEquipment::addMemoryUsage(UeMemoryUsage &usage) const
+{
+    usage.config += sizeof(UeConfig);
+    usage.app += sizeof(UserEquipment) + sizeof(TaskBase);
+
+    if (hibernation != nullptr)
+    {
+        usage.hibernation += sizeof(UeHibernationRecord);
+        if (hibernation->usim != nullptr)
+            usage.hibernation += sizeof(Usim);
+        if (hibernation->timers != nullptr)
+            usage.hibernation += sizeof(UeTimers);
+        for (auto &pduSession : hibernation->pduSessions)
+        {
+            if (pduSession != nullptr)
+                usage.hibernation += sizeof(PduSession);
+        }
+    }
+}
+
 } // namespace nr::ue
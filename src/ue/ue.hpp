@@ -21,15 +21,31 @@ class UserEquipment
 {
   private:
     TaskBase *taskBase;
+    // State of the UE while it is hibernated, i.e. while its tasks other than the app task are torn down
+    std::unique_ptr<UeHibernationRecord> hibernation;
 
   public:
     UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                  NtsTask *cliCallbackTask);
+                  NtsTask *cliCallbackTask, NtsExecutor *executor, UeRlsDemux *rlsDemux, UeHibernator *hibernator,
+                  UeSharedTun *sharedTun);
     virtual ~UserEquipment();
 
   public:
     void start();
     void pushCommand(std::unique_ptr<app::UeCliCommand> cmd, const InetAddress &address);
+    [[nodiscard]] const UeConfig &getConfig() const;
+    // - Must be called before start(), the memory CLI command reports it afterwards.
+    [[nodiscard]] UeMemoryUsage estimateMemoryUsage() const;
+
+  public: /* Used by the app task only */
+    void hibernate();
+    void wake();
+    [[nodiscard]] bool isHibernated() const;
+    // Adds the memory of the UE object, its config and its hibernation record
+    void addMemoryUsage(UeMemoryUsage &usage) const;
+
+  private:
+    void createTasks(UeHibernationRecord *resume);
 };
 
 } // namespace nr::ue
\ No newline at end of file
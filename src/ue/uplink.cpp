@@ -0,0 +1,65 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "uplink.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <ue/rls/demux.hpp>
+
+namespace nr::ue
+{
+
+void UeUplinkFastPath::setOpenSessions(uint32_t psiMask)
+{
+    m_openSessions.store(psiMask, std::memory_order_release);
+}
+
+void UeUplinkFastPath::setRoute(const UeUplinkRoute &route)
+{
+    auto published = std::make_shared<const UeUplinkRoute>(route);
+
+    m_published.erase(std::remove_if(m_published.begin(), m_published.end(), [](auto &item) { return item.expired(); }),
+                      m_published.end());
+    m_published.push_back(published);
+
+    std::atomic_store_explicit(&m_route, std::move(published), std::memory_order_release);
+}
+
+void UeUplinkFastPath::clearRoute()
+{
+    std::atomic_store_explicit(&m_route, std::shared_ptr<const UeUplinkRoute>{}, std::memory_order_release);
+
+    // The receivers hold a route only while sending a batch
+    for (auto &item : m_published)
+    {
+        while (!item.expired())
+            std::this_thread::yield();
+    }
+    m_published.clear();
+}
+
+std::shared_ptr<const UeUplinkRoute> UeUplinkFastPath::acquire(int psi) const
+{
+    if ((m_openSessions.load(std::memory_order_acquire) & (1u << psi)) == 0)
+        return nullptr;
+    return std::atomic_load_explicit(&m_route, std::memory_order_acquire);
+}
+
+void UeUplinkFastPath::Send(const UeUplinkRoute &route, int psi, PacketBuffer &packet)
+{
+    rls::EncodeRlsPduDelivery(route.sti, rls::EPduType::DATA, OctetString::FromOctet4(psi), packet);
+    if (route.demux != nullptr)
+        route.demux->send(route.sti, route.address, packet.data(), packet.length());
+    else
+        route.udpTask->send(route.address, packet.data(), packet.length());
+}
+
+} // namespace nr::ue
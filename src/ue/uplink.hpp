@@ -0,0 +1,62 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <lib/udp/server_task.hpp>
+#include <utils/network.hpp>
+#include <utils/packet_buffer.hpp>
+
+namespace nr::ue
+{
+
+class UeRlsDemux;
+
+// Where the RLS task sends the uplink data PDUs to
+struct UeUplinkRoute
+{
+    uint64_t sti{};
+    InetAddress address{};
+    UeRlsDemux *demux{};              // Used if not null
+    udp::UdpServerTask *udpTask{};    // Socket of the UE otherwise
+};
+
+// Lets the TUN receivers of a UE send the uplink packets directly to the serving cell, instead of passing them through
+// the app and RLS tasks.
+// - The app task publishes the sessions which can send uplink data, i.e. while the UE is connected and no uplink data
+//   is pending for the session. The RLS task publishes the route while it has a serving cell.
+// - The packets are passed through the tasks as usual while either one is not published, e.g. during the state
+//   transitions.
+class UeUplinkFastPath
+{
+  private:
+    std::atomic<uint32_t> m_openSessions{}; // Bit mask of the PSIs
+    std::shared_ptr<const UeUplinkRoute> m_route{};
+    std::vector<std::weak_ptr<const UeUplinkRoute>> m_published{}; // Routes which may still be held by a receiver
+
+  public:
+    /* Used by the app task */
+    void setOpenSessions(uint32_t psiMask);
+
+    /* Used by the RLS task */
+    void setRoute(const UeUplinkRoute &route);
+    // Waits until the route is not used by any receiver anymore, so that its socket can be released
+    void clearRoute();
+
+    /* Used by the TUN receivers */
+    // Returns null if the packets of the session must be passed through the tasks
+    [[nodiscard]] std::shared_ptr<const UeUplinkRoute> acquire(int psi) const;
+    static void Send(const UeUplinkRoute &route, int psi, PacketBuffer &packet);
+};
+
+} // namespace nr::ue
@@ -155,6 +155,14 @@ int64_t utils::CurrentTimeMillis()
     return now;
 }
 
+int64_t utils::MonotonicTimeMillis()
+{
+    auto time = std::chrono::steady_clock::now();
+    auto sinceEpoch = time.time_since_epoch();
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(sinceEpoch);
+    return millis.count();
+}
+
 TimeStamp utils::CurrentTimeStamp()
 {
     int64_t tms = CurrentTimeMillis();
@@ -76,6 +76,55 @@ Json ToJson(const EDeregCause &v)
     }
 }
 
+Json ToJson(const NtsOverflowPolicy &v)
+{
+    switch (v)
+    {
+    case NtsOverflowPolicy::BLOCK:
+        return "block";
+    case NtsOverflowPolicy::DROP_NEWEST:
+        return "drop-newest";
+    case NtsOverflowPolicy::DROP_OLDEST:
+        return "drop-oldest";
+    case NtsOverflowPolicy::DROP_BULK:
+        return "drop-bulk";
+    default:
+        return "?";
+    }
+}
+
+Json ToJson(const NtsQueueStats &v)
+{
+    return Json::Obj({
+        {"capacity", v.capacity == 0 ? Json{"unbounded"} : ToJson(static_cast<int64_t>(v.capacity))},
+        {"policy", ToJson(v.policy)},
+        {"size", static_cast<int64_t>(v.size)},
+        {"bulk-size", static_cast<int64_t>(v.bulkSize)},
+        {"dropped", static_cast<int64_t>(v.dropped)},
+        {"blocked", static_cast<int64_t>(v.blocked)},
+    });
+}
+
+Json ToJson(const NtsAllocatorStats &v)
+{
+    std::vector<Json> classes{};
+    for (auto &item : v.sizeClasses)
+    {
+        classes.push_back(Json::Obj({
+            {"block-size", static_cast<int64_t>(item.blockSize)},
+            {"reserved", static_cast<int64_t>(item.reservedBlocks)},
+            {"depot", static_cast<int64_t>(item.depotBlocks)},
+            {"allocations", static_cast<int64_t>(item.allocations)},
+        }));
+    }
+
+    return Json::Obj({
+        {"size-classes", Json::Arr(std::move(classes))},
+        {"heap-allocations", static_cast<int64_t>(v.heapAllocations)},
+        {"batch-transfers", static_cast<int64_t>(v.batchTransfers)},
+    });
+}
+
 bool operator==(const SingleSlice &lhs, const SingleSlice &rhs)
 {
     if ((int)lhs.sst != (int)rhs.sst)
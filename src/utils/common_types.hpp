@@ -9,6 +9,7 @@
 #pragma once
 
 #include "json.hpp"
+#include "nts.hpp"
 #include "octet.hpp"
 
 #include <memory>
@@ -194,6 +195,9 @@ Json ToJson(const SingleSlice &v);
 Json ToJson(const NetworkSlice &v);
 Json ToJson(const PlmnSupport &v);
 Json ToJson(const EDeregCause &v);
+Json ToJson(const NtsOverflowPolicy &v);
+Json ToJson(const NtsQueueStats &v);
+Json ToJson(const NtsAllocatorStats &v);
 
 namespace std
 {
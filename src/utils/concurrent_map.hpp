@@ -6,54 +6,302 @@
 // and subject to the terms and conditions defined in LICENSE file.
 //
 
-#include <mutex>
-#include <unordered_map>
-
 #pragma once
 
-template <typename TKey, typename TValue>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// A read-mostly hash map for the node registries.
+// - The keys are distributed over shards, each one is an open addressing table of pointers to immutable entries.
+// - Lookups and iteration never take a lock. Writers of the same shard are serialized by the shard's mutex, they
+//   publish new entries and tables atomically, and never wait for the readers.
+// - Replaced entries and tables are retired, and released by a writer once no reader is inside the shard.
+// - Iteration is weakly consistent, i.e. it sees every item that is not modified during the iteration, and may or
+//   may not see the concurrent modifications.
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
 class ConcurrentMap
 {
   private:
-    std::unordered_map<TKey, TValue> m_map{};
-    mutable std::recursive_mutex m_mutex{};
+    static constexpr size_t SHARD_COUNT = 64;
+    static constexpr size_t INITIAL_CAPACITY = 8;
+
+    struct Entry
+    {
+        std::pair<const TKey, TValue> item;
+
+        Entry(const TKey &key, const TValue &value) : item{key, value}
+        {
+        }
+    };
+
+    struct Table
+    {
+        size_t mask;
+        std::unique_ptr<std::atomic<Entry *>[]> slots;
+
+        explicit Table(size_t capacity) : mask{capacity - 1}, slots{new std::atomic<Entry *>[capacity]}
+        {
+            for (size_t i = 0; i < capacity; i++)
+                slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    struct alignas(64) Shard
+    {
+        std::atomic<Table *> table{};
+        std::atomic<int> readers{};
+
+        /* Guarded by the mutex */
+        std::mutex mutex{};
+        size_t count{};
+        size_t used{}; // Including the removed entries
+        std::vector<Entry *> retiredEntries{};
+        std::vector<Table *> retiredTables{};
+    };
+
+    // Marks the slot of a removed entry, so that the probe sequences passing through it are not broken
+    static Entry *Tombstone()
+    {
+        static char tombstone;
+        return reinterpret_cast<Entry *>(&tombstone);
+    }
+
+    class ReadGuard
+    {
+        Shard &m_shard;
+
+      public:
+        explicit ReadGuard(Shard &shard) : m_shard{shard}
+        {
+            m_shard.readers.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        ~ReadGuard()
+        {
+            m_shard.readers.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+  private:
+    std::unique_ptr<Shard[]> m_shards;
+    std::atomic<size_t> m_size{};
+    THash m_hash{};
 
   public:
-    ConcurrentMap() = default;
+    ConcurrentMap() : m_shards{new Shard[SHARD_COUNT]}
+    {
+        for (size_t i = 0; i < SHARD_COUNT; i++)
+            m_shards[i].table.store(new Table(INITIAL_CAPACITY), std::memory_order_relaxed);
+    }
+
+    ~ConcurrentMap()
+    {
+        for (size_t i = 0; i < SHARD_COUNT; i++)
+        {
+            auto &shard = m_shards[i];
+            Table *table = shard.table.load(std::memory_order_relaxed);
+            for (size_t j = 0; j <= table->mask; j++)
+            {
+                Entry *entry = table->slots[j].load(std::memory_order_relaxed);
+                if (entry != nullptr && entry != Tombstone())
+                    delete entry;
+            }
+            delete table;
+            releaseRetired(shard, true);
+        }
+    }
+
+    ConcurrentMap(const ConcurrentMap &) = delete;
+    ConcurrentMap &operator=(const ConcurrentMap &) = delete;
 
   public:
-    TValue getOrDefault(const TKey &key)
+    TValue getOrDefault(const TKey &key) const
     {
-        std::lock_guard lk(m_mutex);
-        if (m_map.count(key) != 0)
-            return m_map[key];
-        return TValue{};
+        size_t hash = mix(m_hash(key));
+        Shard &shard = shardOf(hash);
+        ReadGuard guard{shard};
+
+        Table *table = shard.table.load(std::memory_order_acquire);
+        for (size_t i = slotOf(hash, table);; i = (i + 1) & table->mask)
+        {
+            Entry *entry = table->slots[i].load(std::memory_order_acquire);
+            if (entry == nullptr)
+                return TValue{};
+            if (entry != Tombstone() && entry->item.first == key)
+                return entry->item.second;
+        }
     }
 
     void put(const TKey &key, const TValue &value)
     {
-        std::lock_guard lk(m_mutex);
-        m_map[key] = value;
+        size_t hash = mix(m_hash(key));
+        Shard &shard = shardOf(hash);
+        std::lock_guard lk(shard.mutex);
+
+        auto *entry = new Entry(key, value);
+
+        Table *table = shard.table.load(std::memory_order_relaxed);
+        size_t free = SIZE_MAX;
+        size_t i = slotOf(hash, table);
+        for (;; i = (i + 1) & table->mask)
+        {
+            Entry *current = table->slots[i].load(std::memory_order_relaxed);
+            if (current == nullptr)
+                break;
+            if (current == Tombstone())
+            {
+                if (free == SIZE_MAX)
+                    free = i;
+                continue;
+            }
+            if (current->item.first == key)
+            {
+                table->slots[i].store(entry, std::memory_order_release);
+                shard.retiredEntries.push_back(current);
+                releaseRetired(shard, false);
+                return;
+            }
+        }
+
+        if (free != SIZE_MAX)
+        {
+            table->slots[free].store(entry, std::memory_order_release);
+        }
+        else
+        {
+            table->slots[i].store(entry, std::memory_order_release);
+            shard.used++;
+        }
+        shard.count++;
+        m_size.fetch_add(1, std::memory_order_relaxed);
+
+        // Keeps the load factor below 3/4, the removed entries are dropped while rehashing
+        if (shard.used * 4 > (table->mask + 1) * 3)
+            rehash(shard);
+        releaseRetired(shard, false);
     }
 
+    // Calls the function for each item, the function must not block for long since it delays the release of the
+    // removed items
     template <typename Fun>
     void invokeForeach(const Fun &fun) const
     {
-        std::lock_guard lk(m_mutex);
-        for (auto i : m_map)
-            fun(i);
+        for (size_t s = 0; s < SHARD_COUNT; s++)
+        {
+            Shard &shard = m_shards[s];
+            ReadGuard guard{shard};
+
+            Table *table = shard.table.load(std::memory_order_acquire);
+            for (size_t i = 0; i <= table->mask; i++)
+            {
+                Entry *entry = table->slots[i].load(std::memory_order_acquire);
+                if (entry != nullptr && entry != Tombstone())
+                    fun(entry->item);
+            }
+        }
     }
 
     void remove(const TKey &key)
     {
-        std::lock_guard lk(m_mutex);
-        m_map.erase(key);
+        (void)removeAndGetSize(key);
     }
 
+    // Returns the size after the removal, exactly one of the concurrent removals sees the map becoming empty
     size_t removeAndGetSize(const TKey &key)
     {
-        std::lock_guard lk(m_mutex);
-        m_map.erase(key);
-        return m_map.size();
+        size_t hash = mix(m_hash(key));
+        Shard &shard = shardOf(hash);
+        std::lock_guard lk(shard.mutex);
+
+        Table *table = shard.table.load(std::memory_order_relaxed);
+        for (size_t i = slotOf(hash, table);; i = (i + 1) & table->mask)
+        {
+            Entry *entry = table->slots[i].load(std::memory_order_relaxed);
+            if (entry == nullptr)
+                return m_size.load(std::memory_order_relaxed);
+            if (entry != Tombstone() && entry->item.first == key)
+            {
+                table->slots[i].store(Tombstone(), std::memory_order_release);
+                shard.count--;
+                shard.retiredEntries.push_back(entry);
+                releaseRetired(shard, false);
+                return m_size.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static size_t mix(size_t hash)
+    {
+        // Spreads the identity hashes of the integers
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    Shard &shardOf(size_t hash) const
+    {
+        return m_shards[hash % SHARD_COUNT];
+    }
+
+    static size_t slotOf(size_t hash, const Table *table)
+    {
+        return (hash / SHARD_COUNT) & table->mask;
+    }
+
+    // Shard's mutex must be held
+    void rehash(Shard &shard)
+    {
+        Table *old = shard.table.load(std::memory_order_relaxed);
+
+        size_t capacity = INITIAL_CAPACITY;
+        while (shard.count * 2 > capacity)
+            capacity *= 2;
+
+        auto *table = new Table(capacity);
+        for (size_t i = 0; i <= old->mask; i++)
+        {
+            Entry *entry = old->slots[i].load(std::memory_order_relaxed);
+            if (entry == nullptr || entry == Tombstone())
+                continue;
+
+            size_t j = slotOf(mix(m_hash(entry->item.first)), table);
+            while (table->slots[j].load(std::memory_order_relaxed) != nullptr)
+                j = (j + 1) & table->mask;
+            table->slots[j].store(entry, std::memory_order_relaxed);
+        }
+
+        shard.table.store(table, std::memory_order_release);
+        shard.used = shard.count;
+        shard.retiredTables.push_back(old);
+    }
+
+    // Shard's mutex must be held. The retired objects are unreachable for the readers entering the shard from now on,
+    // hence observing no reader inside the shard once is enough to release them.
+    static void releaseRetired(Shard &shard, bool force)
+    {
+        if (shard.retiredEntries.empty() && shard.retiredTables.empty())
+            return;
+
+        // Read-modify-write, so that a reader entering later synchronizes with the stores unpublishing the objects
+        if (!force && shard.readers.fetch_add(0, std::memory_order_acq_rel) != 0)
+            return;
+
+        for (auto *entry : shard.retiredEntries)
+            delete entry;
+        for (auto *table : shard.retiredTables)
+            delete table;
+        shard.retiredEntries.clear();
+        shard.retiredTables.clear();
     }
-};
\ No newline at end of file
+};
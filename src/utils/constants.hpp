@@ -14,11 +14,11 @@ struct cons
 {
     // Version information
     static constexpr const uint8_t Major = 3;
-    static constexpr const uint8_t Minor = 1;
-    static constexpr const uint8_t Patch = 9;
+    static constexpr const uint8_t Minor = 2;
+    static constexpr const uint8_t Patch = 0;
     static constexpr const char *Project = "UERANSIM";
-    static constexpr const char *Tag = "v3.1.9";
-    static constexpr const char *Name = "UERANSIM v3.1.9";
+    static constexpr const char *Tag = "v3.2.0";
+    static constexpr const char *Name = "UERANSIM v3.2.0";
     static constexpr const char *Owner = "ALİ GÜNGÖR";
 
     // Some port values
@@ -28,10 +28,14 @@ struct cons
     // TUN interface
     static constexpr const char *TunNamePrefix = "uesimtun";
     static constexpr const int TunMtu = 1400;
+    static constexpr const int MaxTunQueues = 16;
 
     // Constraints
     static constexpr const int MinNodeName = 3;
     static constexpr const int MaxNodeName = 1024;
+    static constexpr const int DefaultQueueCapacity = 65536;
+    static constexpr const int DefaultUdpBatchSize = 32;
+    static constexpr const int MaxUdpBatchSize = 256;
 
     // Others
     static constexpr const char *CMD_SERVER_IP = "127.0.0.1";
@@ -7,96 +7,353 @@
 //
 
 #include "logger.hpp"
+#include "memory.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include <spdlog/details/log_msg.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
-Logger::Logger(const std::string &name, const std::vector<std::shared_ptr<spdlog::sinks::sink>> &sinks)
+#define RING_CAPACITY 16384
+#define WRITER_IDLE_WAIT 10
+#define FLUSH_TIMEOUT 1000
+
+namespace logging
+{
+
+struct Slot
+{
+    std::atomic<uint64_t> sequence{};
+    Record record{};
+};
+
+class Backend
+{
+  private:
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<uint64_t> m_enqueuePos{};
+    std::atomic<uint64_t> m_dequeuePos{};
+    std::atomic<uint64_t> m_flushedPos{};
+    std::atomic<uint64_t> m_dropped{};
+
+    std::vector<std::shared_ptr<spdlog::sinks::sink>> m_sinks{};
+
+    std::atomic<bool> m_isIdle{};
+    std::mutex m_mutex{};
+    std::condition_variable m_cv{};
+
+  public:
+    explicit Backend(const LogConfig &config) : m_slots{new Slot[RING_CAPACITY]}
+    {
+        for (uint64_t i = 0; i < RING_CAPACITY; i++)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+        // The sinks are only used by the writer thread
+        if (config.console)
+            m_sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_st>());
+        if (!config.file.empty())
+            m_sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_st>(config.file));
+    }
+
+    Record *claim(Severity severity)
+    {
+        uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = m_slots[pos % RING_CAPACITY];
+            uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.record.position = pos;
+                    return &slot.record;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The ring is full, the debug and info records are dropped, the others wait for the writer
+                if (severity < Severity::WARN)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                std::this_thread::yield();
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commit(Record *record)
+    {
+        m_slots[record->position % RING_CAPACITY].sequence.store(record->position + 1, std::memory_order_release);
+        if (m_isIdle.load(std::memory_order_relaxed))
+            m_cv.notify_one();
+    }
+
+    void flush()
+    {
+        uint64_t target = m_enqueuePos.load(std::memory_order_acquire);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(FLUSH_TIMEOUT);
+        while (m_flushedPos.load(std::memory_order_acquire) < target && std::chrono::steady_clock::now() < deadline)
+        {
+            m_cv.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    [[noreturn]] void run()
+    {
+        std::string text{};
+        bool isDirty = false;
+
+        while (true)
+        {
+            uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+            Slot &slot = m_slots[pos % RING_CAPACITY];
+
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1)
+            {
+                write(slot.record, text);
+                slot.sequence.store(pos + RING_CAPACITY, std::memory_order_release);
+                m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+                isDirty = true;
+                continue;
+            }
+
+            uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped != 0)
+            {
+                text = std::to_string(dropped) + " log records are dropped";
+                writeToSinks(spdlog::details::log_msg{"log", spdlog::level::warn, text});
+                isDirty = true;
+            }
+
+            if (isDirty)
+            {
+                for (auto &sink : m_sinks)
+                    sink->flush();
+                isDirty = false;
+            }
+            m_flushedPos.store(pos, std::memory_order_release);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_isIdle.store(true, std::memory_order_relaxed);
+            m_cv.wait_for(lock, std::chrono::milliseconds(WRITER_IDLE_WAIT));
+            m_isIdle.store(false, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    void write(Record &record, std::string &text)
+    {
+        if (record.formatFn != nullptr)
+            record.formatFn(record, text);
+        else if (record.longText != nullptr)
+            text = std::move(*record.longText);
+        else
+            text.assign(reinterpret_cast<const char *>(record.payload), record.textLength);
+
+        delete record.longText;
+        record.longText = nullptr;
+
+        spdlog::details::log_msg msg{
+            spdlog::log_clock::time_point{std::chrono::duration_cast<spdlog::log_clock::duration>(
+                std::chrono::nanoseconds{record.time})},
+            spdlog::source_loc{}, spdlog::string_view_t{record.tag, record.tagLength}, ToSpdlogLevel(record.severity),
+            text};
+        writeToSinks(msg);
+    }
+
+    void writeToSinks(const spdlog::details::log_msg &msg)
+    {
+        for (auto &sink : m_sinks)
+        {
+            if (sink->should_log(msg.level))
+                sink->log(msg);
+        }
+    }
+
+    static spdlog::level::level_enum ToSpdlogLevel(Severity severity)
+    {
+        switch (severity)
+        {
+        case Severity::DEBUG:
+            return spdlog::level::debug;
+        case Severity::INFO:
+            return spdlog::level::info;
+        case Severity::WARN:
+            return spdlog::level::warn;
+        case Severity::ERR:
+            return spdlog::level::err;
+        case Severity::FATAL:
+        default:
+            return spdlog::level::critical;
+        }
+    }
+};
+
+static LogConfig g_config{};
+static Backend *g_backend = nullptr;
+static std::once_flag g_backendOnce{};
+
+static Backend &GetBackend()
 {
-    logger = new spdlog::logger(name, std::begin(sinks), std::end(sinks));
+    // The backend is never released, so that the records can be logged until the very end of the process
+    std::call_once(g_backendOnce, []() {
+        g_backend = new Backend(g_config);
+        std::thread{[]() { g_backend->run(); }}.detach();
+        std::atexit(Flush);
+    });
+    return *g_backend;
+}
 
-    logger->set_level(spdlog::level::debug);
-    logger->flush_on(spdlog::level::warn);
+void Configure(const LogConfig &config)
+{
+    g_config = config;
 }
 
-Logger::~Logger()
+void Start()
 {
-    delete logger;
+    (void)GetBackend();
 }
 
+void Flush()
+{
+    if (g_backend != nullptr)
+        g_backend->flush();
+}
+
+Record *Claim(Severity severity)
+{
+    // The backend is created by the constructor of the logger
+    return g_backend->claim(severity);
+}
+
+void Commit(Record *record)
+{
+    g_backend->commit(record);
+}
+
+void SetText(Record &record, std::string &&text)
+{
+    record.formatFn = nullptr;
+    if (text.size() <= PAYLOAD_CAPACITY)
+    {
+        std::memcpy(record.payload, text.data(), text.size());
+        record.textLength = static_cast<uint16_t>(text.size());
+    }
+    else
+    {
+        record.longText = new std::string(std::move(text));
+    }
+}
+
+static Severity LevelOf(const std::string &loggerName)
+{
+    // The node prefix is separated by '|', e.g. "imsi-001010000000001|nas"
+    auto separator = loggerName.find_last_of('|');
+    auto component = separator == std::string::npos ? loggerName : loggerName.substr(separator + 1);
+
+    auto it = g_config.componentLevels.find(component);
+    return it != g_config.componentLevels.end() ? it->second : g_config.level;
+}
+
+} // namespace logging
+
+Logger::Logger(const std::string &name, bool isEnabled)
+    : m_name{name}, m_level{logging::LevelOf(name)}, m_isEnabled{isEnabled}
+{
+    logging::Start();
+}
+
+Logger::~Logger() = default;
+
 void Logger::logImpl(Severity severity, const std::string &msg)
 {
-    switch (severity)
+    auto *record = logging::Claim(severity);
+    if (record == nullptr)
+        return;
+
+    fillRecord(*record, severity);
+    logging::SetText(*record, std::string{msg});
+    commitRecord(record);
+}
+
+void Logger::fillRecord(logging::Record &record, Severity severity) const
+{
+    record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    record.severity = severity;
+    record.tagLength = static_cast<uint8_t>(std::min(m_name.size(), logging::TAG_CAPACITY));
+    std::memcpy(record.tag, m_name.data(), record.tagLength);
+    record.formatFn = nullptr;
+    record.longText = nullptr;
+    record.textLength = 0;
+}
+
+void Logger::commitRecord(logging::Record *record)
+{
+    Severity severity = record->severity;
+    logging::Commit(record);
+
+    if (severity == Severity::FATAL)
     {
-    case Severity::DEBUG:
-        logger->debug(msg);
-        break;
-    case Severity::INFO:
-        logger->info(msg);
-        break;
-    case Severity::WARN:
-        logger->warn(msg);
-        break;
-    case Severity::ERR:
-        logger->error(msg);
-        break;
-    case Severity::FATAL:
-        logger->critical(msg);
-        logger->flush();
+        logging::Flush();
         std::terminate();
-        break;
     }
 }
 
 void Logger::flush()
 {
-    logger->flush();
+    logging::Flush();
 }
 
-void Logger::unhandledNts(NtsMessage* msg)
+size_t Logger::memoryUsage() const
 {
-    err("Unhandled NTS message received with type %d", (int)msg->msgType);
+    return sizeof(Logger) + utils::HeapUsage(m_name);
 }
 
-LogBase::LogBase(const std::string &filename)
+void Logger::unhandledNts(NtsMessage *msg)
 {
-    // fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename);
-    // fileSink->set_level(spdlog::level::trace);
-
-    consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-    consoleSink->set_level(spdlog::level::trace); // todo: set to 'trace'.
+    err("Unhandled NTS message received with type %d", (int)msg->msgType);
 }
 
+LogBase::LogBase() = default;
+
 LogBase::~LogBase() = default;
 
-Logger *LogBase::makeLogger(const std::string &loggerName, bool useConsole)
+LogBase *LogBase::Shared()
 {
-    std::vector<std::shared_ptr<spdlog::sinks::sink>> v;
-    // v.push_back(fileSink);
-    if (useConsole)
-        v.push_back(consoleSink);
+    static LogBase instance{};
+    return &instance;
+}
 
-    return new Logger(loggerName, v);
+Logger *LogBase::makeLogger(const std::string &loggerName, bool useConsole)
+{
+    return new Logger(loggerName, useConsole);
 }
 
 std::unique_ptr<Logger> LogBase::makeUniqueLogger(const std::string &loggerName, bool useConsole)
 {
-    std::vector<std::shared_ptr<spdlog::sinks::sink>> v;
-    // v.push_back(fileSink);
-    if (useConsole)
-        v.push_back(consoleSink);
-
-    return std::make_unique<Logger>(loggerName, v);
+    return std::make_unique<Logger>(loggerName, useConsole);
 }
 
 std::shared_ptr<Logger> LogBase::makeSharedLogger(const std::string &loggerName, bool useConsole)
 {
-    std::vector<std::shared_ptr<spdlog::sinks::sink>> v;
-    // v.push_back(fileSink);
-    if (useConsole)
-        v.push_back(consoleSink);
-
-    return std::make_shared<Logger>(loggerName, v);
+    return std::make_shared<Logger>(loggerName, useConsole);
 }
@@ -10,11 +10,18 @@
 
 #include "nts.hpp"
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include <spdlog/fwd.h>
-
 enum class Severity
 {
     DEBUG,
@@ -24,99 +31,252 @@ enum class Severity
     FATAL
 };
 
-class Logger
+// Logging configuration of the process, see logging::Configure
+struct LogConfig
 {
-  private:
-    spdlog::logger *logger;
+    bool console{true};
+    std::string file{};
+    Severity level{Severity::DEBUG};
+    // Minimum severity by component, i.e. the part of the logger name after the node prefix (e.g. "nas", "rls")
+    std::unordered_map<std::string, Severity> componentLevels{};
+};
 
-  public:
-    Logger(const std::string &name, const std::vector<std::shared_ptr<spdlog::sinks::sink>> &sinks);
-    virtual ~Logger();
+// Process-wide asynchronous logging backend.
+// - The records are put into a lock-free ring buffer by the logging threads and written to the sinks by a single
+//   background writer thread, which is started with the first logger.
+// - For a string literal format, the arguments are captured in binary and the formatting is deferred to the writer.
+//   The C string arguments are copied, the other arguments must be scalars.
+// - The debug and info records are dropped if the ring buffer is full, the others wait for space. The number of the
+//   dropped records is reported by the writer.
+namespace logging
+{
 
-  private:
-    void logImpl(Severity severity, const std::string &msg);
+static constexpr size_t TAG_CAPACITY = 40;
+static constexpr size_t PAYLOAD_CAPACITY = 160;
 
-  public:
-    template <typename... Args>
-    inline void debug(const std::string &fmt, Args &&...args)
+struct Record;
+
+using FormatFn = void (*)(const Record &record, std::string &output);
+
+struct Record
+{
+    uint64_t position;
+    int64_t time; // ns since the epoch
+    Severity severity;
+    uint8_t tagLength;
+    char tag[TAG_CAPACITY];
+    const char *format; // Deferred formatting, if formatFn is not null
+    FormatFn formatFn;
+    std::string *longText; // Formatted text not fitting into the payload, if not null
+    uint16_t textLength;   // Formatted text in the payload, otherwise
+    alignas(8) uint8_t payload[PAYLOAD_CAPACITY];
+};
+
+// Must be called before any logger is created
+void Configure(const LogConfig &config);
+// Allocates the ring buffer and starts the writer thread, called by the first logger if not called before
+void Start();
+// Waits until the records logged so far are written to the sinks
+void Flush();
+
+// Returns nullptr if the record is dropped
+Record *Claim(Severity severity);
+void Commit(Record *record);
+
+void SetText(Record &record, std::string &&text);
+
+template <typename T>
+struct LogArg
+{
+    static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+                  "Log arguments must be scalars or C strings");
+
+    using Stored = T;
+
+    static size_t Extra(T)
     {
-        log(Severity::DEBUG, fmt, args...);
+        return 0;
     }
 
-    inline void debug(const std::string &fmt)
+    static Stored Store(T value, uint8_t *, size_t &)
     {
-        log(Severity::DEBUG, fmt);
+        return value;
     }
 
-    template <typename... Args>
-    inline void info(const std::string &fmt, Args &&...args)
+    static T Load(Stored value, const uint8_t *)
+    {
+        return value;
+    }
+};
+
+template <>
+struct LogArg<const char *>
+{
+    using Stored = uint16_t; // Offset of the copy in the payload
+
+    static size_t Extra(const char *value)
+    {
+        return std::strlen(value) + 1;
+    }
+
+    static Stored Store(const char *value, uint8_t *payload, size_t &offset)
     {
-        log(Severity::INFO, fmt, args...);
+        size_t length = std::strlen(value) + 1;
+        std::memcpy(payload + offset, value, length);
+        auto res = static_cast<Stored>(offset);
+        offset += length;
+        return res;
     }
 
-    inline void info(const std::string &fmt)
+    static const char *Load(Stored value, const uint8_t *payload)
     {
-        log(Severity::INFO, fmt);
+        return reinterpret_cast<const char *>(payload + value);
     }
+};
 
+template <>
+struct LogArg<char *> : LogArg<const char *>
+{
+};
+
+template <typename... Args>
+std::string FormatNow(const char *fmt, const Args &...args)
+{
+    int size = snprintf(nullptr, 0, fmt, args...);
+    std::string res;
+    if (size <= 0)
+        return res;
+    res.resize(size);
+    snprintf(&res[0], size + 1, fmt, args...);
+    return res;
+}
+
+template <typename... Args, size_t... I>
+void FormatRecordImpl(const Record &record, std::string &output, std::index_sequence<I...>)
+{
+    using Tuple = std::tuple<typename LogArg<Args>::Stored...>;
+    auto &values = *reinterpret_cast<const Tuple *>(record.payload);
+    output = FormatNow(record.format, LogArg<Args>::Load(std::get<I>(values), record.payload)...);
+}
+
+template <typename... Args>
+void FormatRecord(const Record &record, std::string &output)
+{
+    FormatRecordImpl<Args...>(record, output, std::index_sequence_for<Args...>{});
+}
+
+// Returns false if the arguments do not fit into the payload
+template <typename... Args>
+bool Capture(Record &record, const char *fmt, const Args &...args)
+{
+    using Tuple = std::tuple<typename LogArg<std::decay_t<Args>>::Stored...>;
+    static_assert(alignof(Tuple) <= 8);
+
+    size_t size = sizeof(Tuple);
+    ((size += LogArg<std::decay_t<Args>>::Extra(args)), ...);
+    if (size > PAYLOAD_CAPACITY)
+        return false;
+
+    [[maybe_unused]] size_t offset = sizeof(Tuple);
+    new (record.payload) Tuple{LogArg<std::decay_t<Args>>::Store(args, record.payload, offset)...};
+    record.format = fmt;
+    record.formatFn = &FormatRecord<std::decay_t<Args>...>;
+    return true;
+}
+
+} // namespace logging
+
+class Logger
+{
+  private:
+    std::string m_name;
+    Severity m_level;
+    bool m_isEnabled;
+
+  public:
+    Logger(const std::string &name, bool isEnabled);
+    ~Logger();
+
+  private:
+    void logImpl(Severity severity, const std::string &msg);
+    void fillRecord(logging::Record &record, Severity severity) const;
+    void commitRecord(logging::Record *record);
+
+  public:
     template <typename... Args>
-    inline void warn(const std::string &fmt, Args &&...args)
+    inline void debug(const Args &...args)
     {
-        log(Severity::WARN, fmt, args...);
+        log(Severity::DEBUG, args...);
     }
 
-    inline void warn(const std::string &fmt)
+    template <typename... Args>
+    inline void info(const Args &...args)
     {
-        log(Severity::WARN, fmt);
+        log(Severity::INFO, args...);
     }
 
     template <typename... Args>
-    inline void err(const std::string &fmt, Args &&...args)
+    inline void warn(const Args &...args)
     {
-        log(Severity::ERR, fmt, args...);
+        log(Severity::WARN, args...);
     }
 
-    inline void err(const std::string &fmt)
+    template <typename... Args>
+    inline void err(const Args &...args)
     {
-        log(Severity::ERR, fmt);
+        log(Severity::ERR, args...);
     }
 
     template <typename... Args>
-    inline void fatal(const std::string &fmt, Args &&...args)
+    inline void fatal(const Args &...args)
     {
-        log(Severity::FATAL, fmt, args...);
+        log(Severity::FATAL, args...);
     }
 
-    inline void fatal(const std::string &fmt)
+    // String literal formats are formatted by the writer thread
+    template <size_t N, typename... Args>
+    inline void log(Severity severity, const char (&fmt)[N], const Args &...args)
     {
-        log(Severity::FATAL, fmt);
+        if (severity < m_level || !m_isEnabled)
+            return;
+
+        auto *record = logging::Claim(severity);
+        if (record == nullptr)
+            return;
+
+        fillRecord(*record, severity);
+        if (!logging::Capture(*record, fmt, args...))
+            logging::SetText(*record, logging::FormatNow(fmt, args...));
+        commitRecord(record);
     }
 
     template <typename... Args>
-    inline void log(Severity severity, const std::string &fmt, Args &&...args)
+    inline void log(Severity severity, const std::string &fmt, const Args &...args)
     {
-        int size = snprintf(nullptr, 0, fmt.c_str(), args...);
-        std::string res;
-        res.resize(size);
-        snprintf(&res[0], size + 1, fmt.c_str(), args...);
-        logImpl(severity, res);
+        if (severity < m_level || !m_isEnabled)
+            return;
+
+        logImpl(severity, logging::FormatNow(fmt.c_str(), args...));
     }
 
     void flush();
 
+    // Memory held by the logger object
+    [[nodiscard]] size_t memoryUsage() const;
+
     /* Specific logs */
     void unhandledNts(NtsMessage *msg);
 };
 
+// Creates the loggers of a node, all loggers of the process share the same logging backend
 class LogBase
 {
-  private:
-    // std::shared_ptr<spdlog::sinks::sink> fileSink;
-    std::shared_ptr<spdlog::sinks::sink> consoleSink;
-
   public:
-    explicit LogBase(const std::string &filename);
-    virtual ~LogBase();
+    LogBase();
+    ~LogBase();
+
+    // Returns the instance shared by all nodes of the process
+    static LogBase *Shared();
 
     Logger *makeLogger(const std::string &loggerName, bool useConsole = true);
     std::unique_ptr<Logger> makeUniqueLogger(const std::string &loggerName, bool useConsole = true);
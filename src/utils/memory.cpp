@@ -0,0 +1,41 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "memory.hpp"
+
+#include <fstream>
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace utils
+{
+
+size_t ResidentMemory()
+{
+    // Fields are the total program size and the resident set size, in pages
+    std::ifstream statm{"/proc/self/statm"};
+    size_t size = 0, resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+size_t DefaultThreadStackSize()
+{
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0)
+        return 0;
+    size_t size = 0;
+    if (pthread_getattr_default_np(&attr) != 0 || pthread_attr_getstacksize(&attr, &size) != 0)
+        size = 0;
+    pthread_attr_destroy(&attr);
+    return size;
+}
+
+} // namespace utils
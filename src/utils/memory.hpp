@@ -0,0 +1,58 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Estimates of the heap memory held by the standard containers, assuming the libstdc++ layout and excluding the
+// allocator overhead.
+namespace utils
+{
+
+inline size_t HeapUsage(const std::string &s)
+{
+    // Short strings are stored in place
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <typename T>
+inline size_t HeapUsage(const std::vector<T> &v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+template <typename T>
+inline size_t HeapUsage(const std::deque<T> &d)
+{
+    // Elements are stored in 512 byte blocks, and the block map has at least 8 entries
+    size_t perBlock = std::max<size_t>(1, 512 / sizeof(T));
+    size_t blocks = d.size() / perBlock + 1;
+    return blocks * std::max<size_t>(512, sizeof(T)) + std::max<size_t>(8, blocks + 2) * sizeof(void *);
+}
+
+template <typename K, typename V, typename H, typename E>
+inline size_t HeapUsage(const std::unordered_map<K, V, H, E> &m)
+{
+    // A node holds the next pointer, the item and the cached hash
+    return (m.bucket_count() > 1 ? m.bucket_count() * sizeof(void *) : 0) +
+           m.size() * (sizeof(typename std::unordered_map<K, V, H, E>::value_type) + 2 * sizeof(void *));
+}
+
+// Resident set size of the process in bytes, zero if it is unknown
+size_t ResidentMemory();
+
+// Stack size reserved for a new thread in bytes
+size_t DefaultThreadStackSize();
+
+} // namespace utils
@@ -185,6 +185,24 @@ int Socket::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddre
     return 0;
 }
 
+int Socket::receiveNonBlocking(uint8_t *buffer, size_t bufferSize, InetAddress &outAddress) const
+{
+    sockaddr_storage peerAddr{};
+    socklen_t peerAddrLen = sizeof(struct sockaddr_storage);
+
+    ssize_t rc = recvfrom(fd, buffer, bufferSize, MSG_DONTWAIT, (struct sockaddr *)&peerAddr, &peerAddrLen);
+    if (rc == -1)
+    {
+        int err = errno;
+        if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+            return 0;
+        throw LibError("recvfrom recv failed: ", err);
+    }
+
+    outAddress = InetAddress{peerAddr, peerAddrLen};
+    return static_cast<int>(rc);
+}
+
 void Socket::send(const InetAddress &address, const uint8_t *buffer, size_t size) const
 {
     ssize_t rc = sendto(fd, buffer, size, MSG_DONTWAIT, address.getSockAddr(), address.getSockLen());
@@ -201,6 +219,11 @@ bool Socket::hasFd() const
     return fd >= 0;
 }
 
+int Socket::getFd() const
+{
+    return fd;
+}
+
 Socket Socket::CreateAndBindUdp(const InetAddress &address)
 {
     Socket s(address.getSockAddr()->sa_family, SOCK_DGRAM, IPPROTO_UDP);
@@ -53,9 +53,11 @@ class Socket
   public:
     void bind(const InetAddress &address) const;
     int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outAddress) const;
+    int receiveNonBlocking(uint8_t *buffer, size_t bufferSize, InetAddress &outAddress) const;
     void send(const InetAddress &address, const uint8_t *buffer, size_t size) const;
     void close();
     [[nodiscard]] bool hasFd() const;
+    [[nodiscard]] int getFd() const;
     [[nodiscard]] InetAddress getAddress() const;
 
     /* Socket options */
@@ -8,74 +8,631 @@
 
 #include "nts.hpp"
 #include "common.hpp"
+#include "memory.hpp"
 
+#include <climits>
 #include <stdexcept>
 
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #define WAIT_TIME_IF_NO_TIMER 500
 #define PAUSE_POLLING_PERIOD 20
+#define EXECUTOR_LOOP_BUDGET 32
+#define EXECUTOR_PARK_TIMEOUT 100
+#define ALLOC_CLASS_COUNT 8
+#define ALLOC_BATCH_SIZE 64
+#define ALLOC_CACHE_LIMIT 256
+
+static thread_local int g_workerIndex = -1;
+static thread_local NtsTask *g_currentTask = nullptr;
+static thread_local bool g_isNonBlocking = false;
+
+static constexpr int64_t LEVEL_MASK = TimerBase::LEVEL_SIZE - 1;
+
+static const size_t g_sizeClasses[ALLOC_CLASS_COUNT] = {32, 64, 96, 128, 192, 256, 384, 512};
+
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+struct AllocDepot
+{
+    std::mutex mutex{};
+    std::vector<std::pair<FreeBlock *, int>> batches{};
+    std::atomic<uint64_t> reservedBlocks{};
+    std::atomic<uint64_t> depotBlocks{};
+    std::atomic<uint64_t> allocations{};
+};
+
+static std::atomic<uint64_t> g_heapAllocations{};
+static std::atomic<uint64_t> g_batchTransfers{};
+
+// The cache is trivially destructible so that it remains usable while other thread local objects are being
+// destroyed, the guard returns the cached blocks to the depot at thread exit.
+struct AllocCache
+{
+    FreeBlock *head[ALLOC_CLASS_COUNT];
+    int count[ALLOC_CLASS_COUNT];
+    uint64_t allocations[ALLOC_CLASS_COUNT];
+    bool isDead;
+};
+
+static thread_local AllocCache g_allocCache{};
+
+static AllocDepot *Depots()
+{
+    // Never destroyed, since messages may still be released by other threads during exit.
+    static auto *depots = new AllocDepot[ALLOC_CLASS_COUNT];
+    return depots;
+}
+
+static int SizeClassOf(size_t size)
+{
+    for (int i = 0; i < ALLOC_CLASS_COUNT; i++)
+        if (size <= g_sizeClasses[i])
+            return i;
+    return -1;
+}
+
+static void DepotPut(int cls, FreeBlock *head, int count)
+{
+    auto &depot = Depots()[cls];
+    std::unique_lock<std::mutex> lock(depot.mutex);
+    depot.batches.emplace_back(head, count);
+    depot.depotBlocks += count;
+    g_batchTransfers++;
+}
+
+static FreeBlock *DepotGet(int cls, int &count)
+{
+    auto &depot = Depots()[cls];
+    {
+        std::unique_lock<std::mutex> lock(depot.mutex);
+        if (!depot.batches.empty())
+        {
+            auto batch = depot.batches.back();
+            depot.batches.pop_back();
+            depot.depotBlocks -= batch.second;
+            g_batchTransfers++;
+            count = batch.second;
+            return batch.first;
+        }
+    }
+
+    // Carve a new batch from a single heap allocation
+    size_t blockSize = g_sizeClasses[cls];
+    auto *chunk = static_cast<uint8_t *>(::operator new(blockSize * ALLOC_BATCH_SIZE));
+    FreeBlock *head = nullptr;
+    for (int i = ALLOC_BATCH_SIZE - 1; i >= 0; i--)
+    {
+        auto *block = reinterpret_cast<FreeBlock *>(chunk + blockSize * i);
+        block->next = head;
+        head = block;
+    }
+    depot.reservedBlocks += ALLOC_BATCH_SIZE;
+    count = ALLOC_BATCH_SIZE;
+    return head;
+}
+
+static void PublishAllocations(AllocCache &cache, int cls)
+{
+    Depots()[cls].allocations += cache.allocations[cls];
+    cache.allocations[cls] = 0;
+}
+
+struct AllocCacheGuard
+{
+    ~AllocCacheGuard()
+    {
+        auto &cache = g_allocCache;
+        for (int cls = 0; cls < ALLOC_CLASS_COUNT; cls++)
+        {
+            PublishAllocations(cache, cls);
+            if (cache.head[cls] != nullptr)
+                DepotPut(cls, cache.head[cls], cache.count[cls]);
+            cache.head[cls] = nullptr;
+            cache.count[cls] = 0;
+        }
+        cache.isDead = true;
+    }
+};
+
+static thread_local AllocCacheGuard g_allocCacheGuard;
+
+void *NtsMessage::operator new(std::size_t size)
+{
+    int cls = SizeClassOf(size);
+    if (cls < 0)
+    {
+        g_heapAllocations++;
+        return ::operator new(size);
+    }
+
+    auto &cache = g_allocCache;
+    if (cache.isDead)
+    {
+        int count;
+        FreeBlock *head = DepotGet(cls, count);
+        if (head->next != nullptr)
+            DepotPut(cls, head->next, count - 1);
+        return head;
+    }
+
+    if (cache.head[cls] == nullptr)
+    {
+        (void)g_allocCacheGuard;
+        PublishAllocations(cache, cls);
+        cache.head[cls] = DepotGet(cls, cache.count[cls]);
+    }
+
+    FreeBlock *block = cache.head[cls];
+    cache.head[cls] = block->next;
+    cache.count[cls]--;
+    cache.allocations[cls]++;
+    return block;
+}
+
+void NtsMessage::operator delete(void *ptr, std::size_t size)
+{
+    int cls = SizeClassOf(size);
+    if (cls < 0)
+    {
+        ::operator delete(ptr);
+        return;
+    }
 
-static NtsMessage *TimerExpiredMessage(TimerInfo *timerInfo)
+    auto *block = static_cast<FreeBlock *>(ptr);
+
+    auto &cache = g_allocCache;
+    if (cache.isDead)
+    {
+        block->next = nullptr;
+        DepotPut(cls, block, 1);
+        return;
+    }
+
+    block->next = cache.head[cls];
+    cache.head[cls] = block;
+    cache.count[cls]++;
+
+    // Give a batch back, so that the blocks released by a consumer thread can be reused by the producer threads
+    if (cache.count[cls] > ALLOC_CACHE_LIMIT)
+    {
+        (void)g_allocCacheGuard;
+        FreeBlock *head = cache.head[cls];
+        FreeBlock *tail = head;
+        for (int i = 1; i < ALLOC_BATCH_SIZE; i++)
+            tail = tail->next;
+        cache.head[cls] = tail->next;
+        cache.count[cls] -= ALLOC_BATCH_SIZE;
+        tail->next = nullptr;
+
+        PublishAllocations(cache, cls);
+        DepotPut(cls, head, ALLOC_BATCH_SIZE);
+    }
+}
+
+NtsAllocatorStats NtsMessage::AllocatorStats()
+{
+    NtsAllocatorStats stats{};
+    for (int cls = 0; cls < ALLOC_CLASS_COUNT; cls++)
+    {
+        auto &depot = Depots()[cls];
+        NtsAllocatorStats::SizeClass item{};
+        item.blockSize = g_sizeClasses[cls];
+        item.reservedBlocks = depot.reservedBlocks;
+        item.depotBlocks = depot.depotBlocks;
+        item.allocations = depot.allocations;
+        stats.sizeClasses.push_back(item);
+    }
+    stats.heapAllocations = g_heapAllocations;
+    stats.batchTransfers = g_batchTransfers;
+    return stats;
+}
+
+NtsSlotPool::NtsSlotPool(size_t slotSize, uint32_t slotCount)
+    : slotSize{slotSize}, slotCount{slotCount}, storage{}, nextFree{new std::atomic<uint32_t>[slotCount]}
+{
+    storage = static_cast<uint8_t *>(::operator new(slotSize * slotCount));
+}
+
+void *NtsSlotPool::allocate(size_t size)
+{
+    if (size != slotSize)
+        return ::operator new(size);
+
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    while ((head & 0xFFFFFFFFull) != 0)
+    {
+        auto index = static_cast<uint32_t>(head & 0xFFFFFFFFull) - 1;
+        uint64_t next = (((head >> 32) + 1) << 32) | nextFree[index].load(std::memory_order_relaxed);
+        if (freeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+            return storage + static_cast<size_t>(index) * slotSize;
+    }
+
+    // Slots which have never been used yet
+    if (bumpIndex.load(std::memory_order_relaxed) < slotCount)
+    {
+        uint32_t index = bumpIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index < slotCount)
+            return storage + static_cast<size_t>(index) * slotSize;
+    }
+
+    return ::operator new(size);
+}
+
+void NtsSlotPool::deallocate(void *ptr, size_t size)
 {
-    return timerInfo ? new NwTimerExpired(timerInfo->timerId) : nullptr;
+    auto *p = static_cast<uint8_t *>(ptr);
+    if (size != slotSize || p < storage || p >= storage + slotSize * slotCount)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    auto index = static_cast<uint32_t>((p - storage) / slotSize);
+    uint64_t head = freeHead.load(std::memory_order_relaxed);
+    uint64_t next;
+    do
+    {
+        nextFree[index].store(static_cast<uint32_t>(head & 0xFFFFFFFFull), std::memory_order_relaxed);
+        next = (((head >> 32) + 1) << 32) | (static_cast<uint64_t>(index) + 1);
+    } while (!freeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
 }
 
-void TimerBase::setTimerAbsolute(int timerId, int64_t timeMs)
+static uint64_t RotateRight(uint64_t value, int n)
 {
-    auto *timerInfo = new TimerInfo();
-    timerInfo->start = utils::CurrentTimeMillis();
-    timerInfo->end = timeMs;
-    timerInfo->timerId = timerId;
+    return n == 0 ? value : (value >> n) | (value << (64 - n));
+}
 
-    timerQueue.push(timerInfo);
+TimerBase::TimerBase(int64_t now) : current{now}
+{
 }
 
-int64_t TimerBase::getNextWaitTime()
+NtsTimerHandle TimerBase::setTimerAbsolute(int timerId, int64_t timeMs, int64_t now, int64_t period)
 {
-    if (timerQueue.empty())
-        return WAIT_TIME_IF_NO_TIMER;
+    advance(now);
 
-    auto delta = timerQueue.top()->end - utils::CurrentTimeMillis();
-    return delta < 0 ? 0 : delta;
+    TimerInfo *timer;
+    if (!freeRecords.empty())
+    {
+        timer = freeRecords.back();
+        freeRecords.pop_back();
+    }
+    else
+    {
+        timer = &records.emplace_back();
+        timer->index = static_cast<uint32_t>(records.size() - 1);
+    }
+
+    timer->timerId = timerId;
+    timer->start = now;
+    timer->end = timeMs;
+    timer->period = period;
+    insert(timer);
+
+    return (static_cast<uint64_t>(timer->generation) << 32) | (static_cast<uint64_t>(timer->index) + 1);
 }
 
-TimerInfo *TimerBase::getAndRemoveExpiredTimer()
+bool TimerBase::reschedule(NtsTimerHandle handle, int64_t timeMs, int64_t now)
 {
-    if (timerQueue.empty())
+    TimerInfo *timer = find(handle);
+    if (timer == nullptr)
+        return false;
+
+    advance(now);
+    unlink(timer);
+    timer->start = now;
+    timer->end = timeMs;
+    insert(timer);
+    return true;
+}
+
+bool TimerBase::cancel(NtsTimerHandle handle)
+{
+    TimerInfo *timer = find(handle);
+    if (timer == nullptr)
+        return false;
+
+    unlink(timer);
+    release(timer);
+    return true;
+}
+
+bool TimerBase::getAndRemoveExpiredTimer(int64_t now, int &timerId)
+{
+    advance(now);
+
+    TimerInfo *timer = expired;
+    if (timer == nullptr)
+        return false;
+
+    timerId = timer->timerId;
+    unlink(timer);
+
+    if (timer->period > 0)
+    {
+        timer->start = now;
+        timer->end += timer->period;
+        if (timer->end < now)
+            timer->end = now + timer->period;
+        insert(timer);
+    }
+    else
+    {
+        release(timer);
+    }
+    return true;
+}
+
+int64_t TimerBase::getNextExpiryTime() const
+{
+    if (expired != nullptr)
+        return current - 1;
+    if (count == 0)
+        return 0;
+    return nextEventTick() - 1;
+}
+
+bool TimerBase::isEmpty() const
+{
+    return expired == nullptr && count == 0;
+}
+
+size_t TimerBase::heapUsage() const
+{
+    return utils::HeapUsage(records) + utils::HeapUsage(freeRecords);
+}
+
+TimerInfo *TimerBase::find(NtsTimerHandle handle)
+{
+    uint64_t index = (handle & 0xFFFFFFFFull);
+    if (index == 0 || index > records.size())
+        return nullptr;
+
+    TimerInfo *timer = &records[index - 1];
+    if (timer->generation != static_cast<uint32_t>(handle >> 32) || timer->list == nullptr)
         return nullptr;
+    return timer;
+}
+
+void TimerBase::insert(TimerInfo *timer)
+{
+    // The timer expires at the first tick strictly greater than its end time
+    int64_t tick = timer->end + 1;
+    int64_t delta = tick - current;
 
-    TimerInfo *timer = timerQueue.top();
-    if (timer->end < utils::CurrentTimeMillis())
+    if (delta <= 0)
     {
-        timerQueue.pop();
-        return timer;
+        timer->list = &expired;
+        timer->prev = expiredTail;
+        timer->next = nullptr;
+        if (expiredTail)
+            expiredTail->next = timer;
+        else
+            expired = timer;
+        expiredTail = timer;
+        return;
     }
 
-    return nullptr;
+    int level = 0;
+    while (level < LEVEL_COUNT - 1 && delta >= (int64_t{1} << (LEVEL_BITS * (level + 1))))
+        level++;
+
+    // Out of range timers are parked at the farthest slot, and placed again when that slot is cascaded.
+    if (delta >= (int64_t{1} << (LEVEL_BITS * LEVEL_COUNT)))
+        tick = current + (int64_t{1} << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+
+    int slot = static_cast<int>((tick >> (LEVEL_BITS * level)) & LEVEL_MASK);
+
+    TimerInfo *&list = wheel[level][slot];
+    timer->list = &list;
+    timer->prev = nullptr;
+    timer->next = list;
+    if (list)
+        list->prev = timer;
+    list = timer;
+
+    occupied[level] |= uint64_t{1} << slot;
+    count++;
+}
+
+void TimerBase::unlink(TimerInfo *timer)
+{
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        *timer->list = timer->next;
+
+    if (timer->next)
+        timer->next->prev = timer->prev;
+    else if (timer->list == &expired)
+        expiredTail = timer->prev;
+
+    if (timer->list != &expired)
+    {
+        count--;
+        if (*timer->list == nullptr)
+        {
+            auto offset = timer->list - &wheel[0][0];
+            occupied[offset / LEVEL_SIZE] &= ~(uint64_t{1} << (offset % LEVEL_SIZE));
+        }
+    }
+
+    timer->list = nullptr;
+    timer->prev = nullptr;
+    timer->next = nullptr;
+}
+
+void TimerBase::release(TimerInfo *timer)
+{
+    // Invalidate the handles referring to this record
+    timer->generation++;
+    freeRecords.push_back(timer);
 }
 
-TimerBase::~TimerBase()
+int64_t TimerBase::nextEventTick() const
 {
-    while (!timerQueue.empty())
+    int64_t best = INT64_MAX;
+
+    // For level 0 this is the exact expiry tick, for the upper levels it is the time the slot is cascaded.
+    for (int level = 0; level < LEVEL_COUNT; level++)
     {
-        delete timerQueue.top();
-        timerQueue.pop();
+        if (occupied[level] == 0)
+            continue;
+
+        int shift = LEVEL_BITS * level;
+        int64_t base = current >> shift;
+        int index = static_cast<int>((base + 1) & LEVEL_MASK);
+        int distance = __builtin_ctzll(RotateRight(occupied[level], index)) + 1;
+
+        best = std::min(best, (base + distance) << shift);
     }
+
+    return best;
 }
 
-bool NtsTask::push(NtsMessage *msg)
+void TimerBase::cascade()
 {
-    if (isQuiting)
+    for (int level = 1; level < LEVEL_COUNT; level++)
+    {
+        int slot = static_cast<int>((current >> (LEVEL_BITS * level)) & LEVEL_MASK);
+
+        TimerInfo *timer = wheel[level][slot];
+        wheel[level][slot] = nullptr;
+        occupied[level] &= ~(uint64_t{1} << slot);
+
+        while (timer)
+        {
+            TimerInfo *next = timer->next;
+            count--;
+            insert(timer);
+            timer = next;
+        }
+
+        if (slot != 0)
+            break;
+    }
+}
+
+void TimerBase::advance(int64_t now)
+{
+    while (count > 0)
+    {
+        int64_t tick = nextEventTick();
+        if (tick > now)
+            break;
+
+        current = tick;
+        if ((current & LEVEL_MASK) == 0)
+            cascade();
+
+        int slot = static_cast<int>(current & LEVEL_MASK);
+        TimerInfo *timer = wheel[0][slot];
+        wheel[0][slot] = nullptr;
+        occupied[0] &= ~(uint64_t{1} << slot);
+
+        while (timer)
+        {
+            TimerInfo *next = timer->next;
+            count--;
+            insert(timer);
+            timer = next;
+        }
+    }
+
+    if (current < now)
+        current = now;
+}
+
+NtsMailbox::NtsMailbox() : head{&stub}, tail{&stub}
+{
+}
+
+void NtsMailbox::push(NtsMessage *msg)
+{
+    msg->mailboxNext.store(nullptr, std::memory_order_relaxed);
+    NtsMessage *prev = head.exchange(msg, std::memory_order_seq_cst);
+    prev->mailboxNext.store(msg, std::memory_order_release);
+}
+
+NtsMessage *NtsMailbox::pop()
+{
+    NtsMessage *first = tail;
+    NtsMessage *next = first->mailboxNext.load(std::memory_order_acquire);
+
+    if (first == &stub)
+    {
+        if (next == nullptr)
+            return nullptr;
+        tail = next;
+        first = next;
+        next = next->mailboxNext.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+        tail = next;
+        return first;
+    }
+
+    // A producer is in the middle of push()
+    if (first != head.load(std::memory_order_acquire))
+        return nullptr;
+
+    // Last message in the queue, put the stub back so that 'first' can be detached
+    push(&stub);
+
+    next = first->mailboxNext.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+        tail = next;
+        return first;
+    }
+    return nullptr;
+}
+
+bool NtsMailbox::isEmpty() const
+{
+    // The stub is always re-pushed when the last message is popped, hence head points to the stub iff empty.
+    return head.load(std::memory_order_seq_cst) == &stub;
+}
+
+static void FutexWait(std::atomic_int *address, int expected, int64_t timeoutMs)
+{
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(timeoutMs / 1000);
+    ts.tv_nsec = static_cast<long>((timeoutMs % 1000) * 1000000);
+    syscall(SYS_futex, reinterpret_cast<int *>(address), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+}
+
+static void FutexWake(std::atomic_int *address, int count)
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(address), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+bool NtsTask::push(NtsMessage *msg, NtsLane lane)
+{
+    if (isQuiting || (capacity != 0 && queuedCount >= capacity && !admit(lane)))
     {
         delete msg;
         return false;
     }
 
+    queuedCount++;
+    if (lane == NtsLane::BULK)
     {
-        std::unique_lock<std::mutex> lock(mutex);
-        msgQueue.push_back(msg);
+        bulkQueuedCount++;
+        bulkMailbox.push(msg);
     }
-
-    cv.notify_one();
+    else
+    {
+        mailbox.push(msg);
+    }
+    wake();
     return true;
 }
 
@@ -87,108 +644,260 @@ bool NtsTask::pushFront(NtsMessage *msg)
         return false;
     }
 
+    queuedCount++;
     {
         std::unique_lock<std::mutex> lock(mutex);
-        msgQueue.push_front(msg);
+        frontQueue.push_front(msg);
+        hasFrontMessage = true;
     }
 
-    cv.notify_one();
+    wake();
     return true;
 }
 
-bool NtsTask::setTimer(int timerId, int64_t delayMs)
+NtsTimerHandle NtsTask::setTimer(int timerId, int64_t delayMs)
+{
+    return setTimerAbsolute(timerId, utils::MonotonicTimeMillis() + delayMs);
+}
+
+NtsTimerHandle NtsTask::setTimerAbsolute(int timerId, int64_t timeMs)
+{
+    return armTimer(timerId, timeMs, 0);
+}
+
+NtsTimerHandle NtsTask::setPeriodicTimer(int timerId, int64_t periodMs)
+{
+    if (periodMs <= 0)
+        throw std::runtime_error("Invalid timer period");
+    return armTimer(timerId, utils::MonotonicTimeMillis() + periodMs, periodMs);
+}
+
+NtsTimerHandle NtsTask::armTimer(int timerId, int64_t timeMs, int64_t period)
+{
+    if (isQuiting)
+        return 0;
+
+    NtsTimerHandle handle;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        handle = timerBase.setTimerAbsolute(timerId, timeMs, utils::MonotonicTimeMillis(), period);
+        nextTimerExpiry = timerBase.getNextExpiryTime();
+    }
+
+    if (auto *exec = executor.load())
+        exec->scheduleAt(this, timeMs);
+    else
+        wake();
+    return handle;
+}
+
+bool NtsTask::cancelTimer(NtsTimerHandle handle)
 {
-    return setTimerAbsolute(timerId, utils::CurrentTimeMillis() + delayMs);
+    std::unique_lock<std::mutex> lock(mutex);
+    bool cancelled = timerBase.cancel(handle);
+    nextTimerExpiry = timerBase.getNextExpiryTime();
+    return cancelled;
 }
 
-bool NtsTask::setTimerAbsolute(int timerId, int64_t timeMs)
+bool NtsTask::rescheduleTimer(NtsTimerHandle handle, int64_t delayMs)
 {
     if (isQuiting)
         return false;
 
+    int64_t now = utils::MonotonicTimeMillis();
     {
         std::unique_lock<std::mutex> lock(mutex);
-        timerBase.setTimerAbsolute(timerId, timeMs);
+        if (!timerBase.reschedule(handle, now + delayMs, now))
+            return false;
+        nextTimerExpiry = timerBase.getNextExpiryTime();
     }
 
-    cv.notify_one();
+    if (auto *exec = executor.load())
+        exec->scheduleAt(this, now + delayMs);
+    else
+        wake();
     return true;
 }
 
+bool NtsTask::admit(NtsLane lane)
+{
+    switch (overflowPolicy)
+    {
+    case NtsOverflowPolicy::BLOCK: {
+        // Never block a task or the executor workers, otherwise the consumer (or two tasks pushing to each other) may
+        // never run again.
+        bool isConsumer = g_currentTask == this || std::this_thread::get_id() == thread.get_id();
+        if (isConsumer || g_currentTask != nullptr || g_workerIndex >= 0)
+            return true;
+        if (g_isNonBlocking)
+        {
+            droppedCount++;
+            return false;
+        }
+
+        blockedCount++;
+        while (queuedCount >= capacity && !isQuiting)
+        {
+            spaceState.store(1, std::memory_order_seq_cst);
+            if (queuedCount >= capacity && !isQuiting)
+                FutexWait(&spaceState, 1, PAUSE_POLLING_PERIOD);
+        }
+        return !isQuiting;
+    }
+    case NtsOverflowPolicy::DROP_NEWEST:
+        droppedCount++;
+        return false;
+    case NtsOverflowPolicy::DROP_OLDEST:
+        return true;
+    case NtsOverflowPolicy::DROP_BULK:
+        if (lane == NtsLane::BULK)
+        {
+            droppedCount++;
+            return false;
+        }
+        return true;
+    }
+    return true;
+}
+
+void NtsTask::MarkNonBlockingThread()
+{
+    g_isNonBlocking = true;
+}
+
+NtsMessage *NtsTask::dequeue(NtsMailbox &box)
+{
+    NtsMessage *msg = box.pop();
+    if (msg != nullptr)
+        onDequeued(&box == &bulkMailbox);
+    return msg;
+}
+
+void NtsTask::onDequeued(bool isBulk)
+{
+    queuedCount--;
+    if (isBulk)
+        bulkQueuedCount--;
+
+    if (spaceState.load(std::memory_order_seq_cst) != 0 && spaceState.exchange(0) != 0)
+        FutexWake(&spaceState, INT_MAX);
+}
+
+void NtsTask::dropOldest()
+{
+    while (queuedCount > capacity)
+    {
+        NtsMessage *msg = bulkQueuedCount > 0 ? dequeue(bulkMailbox) : nullptr;
+        if (msg == nullptr)
+            msg = dequeue(mailbox);
+        if (msg == nullptr)
+            break;
+
+        delete msg;
+        droppedCount++;
+    }
+}
+
 NtsMessage *NtsTask::poll()
 {
+    if (hasFrontMessage)
     {
         std::unique_lock<std::mutex> lock(mutex);
-        if (!msgQueue.empty())
+        if (!frontQueue.empty())
         {
-            NtsMessage *ret = msgQueue.front();
-            msgQueue.pop_front();
+            NtsMessage *ret = frontQueue.front();
+            frontQueue.pop_front();
+            hasFrontMessage = !frontQueue.empty();
+            lock.unlock();
+
+            onDequeued(false);
             return ret;
         }
     }
 
+    if (capacity != 0 && overflowPolicy == NtsOverflowPolicy::DROP_OLDEST)
+        dropOldest();
+
+    NtsMessage *msg = dequeue(mailbox);
+    if (msg != nullptr)
+        return msg;
+
     if (isQuiting)
         return nullptr;
-    TimerInfo *expiredTimer;
 
+    // Timers are considered as control messages
+    msg = pollTimer();
+    if (msg != nullptr)
+        return msg;
+
+    return dequeue(bulkMailbox);
+}
+
+NtsMessage *NtsTask::pollTimer()
+{
+    // Avoid locking unless a timer may have been expired
+    int64_t now = utils::MonotonicTimeMillis();
+    int64_t expiry = nextTimerExpiry;
+    if (expiry == 0 || expiry >= now)
+        return nullptr;
+
+    int timerId;
+    bool isExpired;
     {
         std::unique_lock<std::mutex> lock(mutex);
-        expiredTimer = timerBase.getAndRemoveExpiredTimer();
+        isExpired = timerBase.getAndRemoveExpiredTimer(now, timerId);
+        nextTimerExpiry = timerBase.getNextExpiryTime();
     }
 
-    if (expiredTimer != nullptr)
-    {
-        NtsMessage *msg = TimerExpiredMessage(expiredTimer);
-        delete expiredTimer;
-        return msg;
-    }
-    return nullptr;
+    return isExpired ? new NwTimerExpired(timerId) : nullptr;
 }
 
 NtsMessage *NtsTask::poll(int64_t timeout)
 {
+    // Tasks running on an executor must never block a worker thread
+    if (executor.load() != nullptr)
+        return poll();
+
     timeout = std::min(timeout, (int64_t)WAIT_TIME_IF_NO_TIMER);
 
     if (isQuiting)
         return nullptr;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        if (!msgQueue.empty())
-        {
-            NtsMessage *ret = msgQueue.front();
-            msgQueue.pop_front();
-            return ret;
-        }
-        cv.wait_for(lock, std::chrono::milliseconds(std::min(timerBase.getNextWaitTime(), timeout)));
-    }
+    NtsMessage *msg = poll();
+    if (msg != nullptr)
+        return msg;
+
+    // Timers are expired with strict comparison, hence wait until one millisecond after the expiry time.
+    int64_t expiry = nextTimerExpiry;
+    if (expiry != 0)
+        timeout = std::min(timeout, std::max(expiry - utils::MonotonicTimeMillis() + 1, (int64_t)0));
+    park(timeout);
 
     if (isQuiting)
         return nullptr;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        if (!msgQueue.empty())
-        {
-            NtsMessage *ret = msgQueue.front();
-            msgQueue.pop_front();
-            return ret;
-        }
-    }
+    return poll();
+}
 
-    TimerInfo *expiredTimer;
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        expiredTimer = timerBase.getAndRemoveExpiredTimer();
-    }
+void NtsTask::park(int64_t timeout)
+{
+    if (timeout <= 0)
+        return;
 
-    if (expiredTimer != nullptr)
-    {
-        NtsMessage *msg = TimerExpiredMessage(expiredTimer);
-        delete expiredTimer;
-        return msg;
-    }
-    return nullptr;
+    // Announce parking before checking the mailbox, so that either the producer sees the parked state or we see the
+    // pushed message.
+    parkState.store(1, std::memory_order_seq_cst);
+    if (mailbox.isEmpty() && bulkMailbox.isEmpty() && !hasFrontMessage && !isQuiting && pauseReqCount == 0)
+        FutexWait(&parkState, 1, timeout);
+    parkState.store(0, std::memory_order_relaxed);
+}
+
+void NtsTask::wake()
+{
+    if (auto *exec = executor.load())
+        exec->schedule(this);
+    else if (parkState.load(std::memory_order_seq_cst) != 0 && parkState.exchange(0) != 0)
+        FutexWake(&parkState, 1);
 }
 
 NtsMessage *NtsTask::take()
@@ -196,13 +905,42 @@ NtsMessage *NtsTask::take()
     return poll(WAIT_TIME_IF_NO_TIMER);
 }
 
-void NtsTask::start()
+size_t NtsTask::takeBatch(std::vector<NtsMessage *> &batch, size_t max)
+{
+    return takeBatch(batch, max, WAIT_TIME_IF_NO_TIMER);
+}
+
+size_t NtsTask::takeBatch(std::vector<NtsMessage *> &batch, size_t max, int64_t timeout)
+{
+    batch.clear();
+    if (max == 0)
+        return 0;
+
+    NtsMessage *msg = poll(timeout);
+    while (msg != nullptr)
+    {
+        batch.push_back(msg);
+        if (batch.size() >= max)
+            break;
+        msg = poll();
+    }
+    return batch.size();
+}
+
+void NtsTask::start(NtsExecutor *exec)
 {
     onStart();
 
-    if (!isQuiting)
+    if (!isQuiting && exec != nullptr)
+    {
+        // Timers armed in onStart() are registered to the executor after the first execution
+        executor = exec;
+        exec->schedule(this);
+    }
+    else if (!isQuiting)
     {
         thread = std::thread{[this]() {
+            g_currentTask = this;
             while (true)
             {
                 if (this->isQuiting)
@@ -225,25 +963,61 @@ void NtsTask::start()
 
 void NtsTask::quit()
 {
-    bool expected = false;
-    while (!isQuiting.compare_exchange_weak(expected, true, std::memory_order_relaxed, std::memory_order_relaxed))
+    if (isQuiting.exchange(true))
         return;
 
-    cv.notify_one();
+    wake();
+    FutexWake(&spaceState, INT_MAX);
 
     if (thread.joinable())
         thread.join();
 
+    if (auto *exec = executor.load())
+    {
+        exec->cancel(this);
+        exec->unschedule(this);
+
+        // Wait until no worker refers to this task anymore (unless quit() is called by the task itself). The task is
+        // taken out of the run queues meanwhile, since it may be queued on the very worker calling quit().
+        if (g_currentTask != this)
+        {
+            while (inFlight > 0)
+            {
+                std::this_thread::yield();
+                exec->unschedule(this);
+            }
+        }
+
+        // The last execution may have added a wakeup before seeing isQuiting
+        exec->cancel(this);
+    }
+
     {
         std::unique_lock<std::mutex> lock(mutex);
-        while (!msgQueue.empty())
+        while (!frontQueue.empty())
         {
-            NtsMessage *msg = msgQueue.front();
-            msgQueue.pop_front();
+            NtsMessage *msg = frontQueue.front();
+            frontQueue.pop_front();
 
             // Since we have the ownership at this time, we should delete the messages.
             delete msg;
         }
+        hasFrontMessage = false;
+    }
+
+    for (NtsMailbox *box : {&mailbox, &bulkMailbox})
+    {
+        while (!box->isEmpty())
+        {
+            NtsMessage *msg = box->pop();
+            if (msg == nullptr)
+            {
+                // A concurrent push() is not completed yet
+                std::this_thread::yield();
+                continue;
+            }
+            delete msg;
+        }
     }
 
     onQuit();
@@ -255,7 +1029,7 @@ void NtsTask::requestPause()
         throw std::runtime_error("NTS pause overflow");
 
     if (!isQuiting)
-        cv.notify_one();
+        wake();
 }
 
 void NtsTask::requestUnpause()
@@ -268,3 +1042,295 @@ bool NtsTask::isPauseConfirmed()
 {
     return pauseConfirmed;
 }
+
+void NtsTask::setQueueCapacity(size_t queueCapacity, NtsOverflowPolicy policy)
+{
+    capacity = queueCapacity;
+    overflowPolicy = policy;
+}
+
+NtsQueueStats NtsTask::getQueueStats() const
+{
+    NtsQueueStats stats{};
+    stats.capacity = capacity;
+    stats.policy = overflowPolicy;
+    stats.size = queuedCount;
+    stats.bulkSize = bulkQueuedCount;
+    stats.dropped = droppedCount;
+    stats.blocked = blockedCount;
+    return stats;
+}
+
+size_t NtsTask::heapUsage()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return utils::HeapUsage(frontQueue) + timerBase.heapUsage();
+}
+
+bool NtsTask::hasPendingWork()
+{
+    if (!mailbox.isEmpty() || !bulkMailbox.isEmpty() || hasFrontMessage)
+        return true;
+    int64_t expiry = nextTimerExpiry;
+    return expiry != 0 && expiry < utils::MonotonicTimeMillis();
+}
+
+void NtsTask::executeOnce()
+{
+    for (int i = 0; i < EXECUTOR_LOOP_BUDGET; i++)
+    {
+        if (isQuiting)
+            return;
+
+        if (pauseReqCount > 0)
+        {
+            pauseConfirmed = true;
+            if (!isQuiting)
+                executor.load()->scheduleAt(this, utils::MonotonicTimeMillis() + PAUSE_POLLING_PERIOD);
+            return;
+        }
+
+        pauseConfirmed = false;
+        onLoop();
+
+        if (!hasPendingWork())
+            break;
+    }
+
+    // The timing wheel may report an earlier time than the actual expiry for far timers, therefore the task should be
+    // woken up again at the reported time to advance the wheel.
+    int64_t expiry = nextTimerExpiry;
+    if (expiry != 0 && !isQuiting)
+        executor.load()->scheduleAt(this, expiry);
+}
+
+NtsExecutor::NtsExecutor(int threadCount)
+{
+    if (threadCount <= 0)
+        throw std::runtime_error("Invalid number of executor threads");
+
+    for (int i = 0; i < threadCount; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < threadCount; i++)
+        workers[i]->thread = std::thread{[this, i]() { workerLoop(i); }};
+
+    timerThread = std::thread{[this]() { timerLoop(); }};
+}
+
+NtsExecutor::~NtsExecutor()
+{
+    isQuiting = true;
+
+    {
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parkCv.notify_all();
+    }
+    {
+        std::unique_lock<std::mutex> lock(timerMutex);
+        timerCv.notify_all();
+    }
+
+    for (auto &worker : workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+    if (timerThread.joinable())
+        timerThread.join();
+}
+
+int NtsExecutor::threadCount() const
+{
+    return static_cast<int>(workers.size());
+}
+
+void NtsExecutor::schedule(NtsTask *task)
+{
+    if (task->isScheduled.exchange(true))
+        return;
+
+    // Counted before checking isQuiting, so that either quit() waits for this reference or this sees isQuiting
+    task->inFlight++;
+    if (task->isQuiting)
+    {
+        task->isScheduled = false;
+        task->inFlight--;
+        return;
+    }
+
+    // Prefer the run queue of the current worker for locality, otherwise distribute evenly.
+    size_t index = g_workerIndex >= 0 ? static_cast<size_t>(g_workerIndex) : nextWorker++ % workers.size();
+
+    auto &worker = workers[index];
+    {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        worker->runQueue.push_back(task);
+    }
+
+    if (parkedCount > 0)
+    {
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parkCv.notify_one();
+    }
+}
+
+void NtsExecutor::scheduleAt(NtsTask *task, int64_t timeMs)
+{
+    // A later wakeup is not needed if an earlier one is pending, since the task arms its next timer whenever it runs.
+    // Checked without the lock first, as the task asks for the same wakeup after each execution.
+    int64_t pending = task->wakeupTime;
+    if (pending != 0 && pending <= timeMs)
+        return;
+
+    std::unique_lock<std::mutex> lock(timerMutex);
+    // Checked under the lock, since quit() cancels the wakeup under the lock after setting isQuiting
+    if (task->isQuiting)
+        return;
+
+    pending = task->wakeupTime;
+    if (pending != 0)
+    {
+        if (pending <= timeMs)
+            return;
+        wakeups.erase({pending, task});
+    }
+
+    task->wakeupTime = timeMs;
+    bool isEarliest = wakeups.empty() || timeMs < wakeups.begin()->first;
+    wakeups.emplace(timeMs, task);
+    if (isEarliest)
+        timerCv.notify_one();
+}
+
+void NtsExecutor::cancel(NtsTask *task)
+{
+    std::unique_lock<std::mutex> lock(timerMutex);
+    int64_t pending = task->wakeupTime;
+    if (pending != 0)
+    {
+        wakeups.erase({pending, task});
+        task->wakeupTime = 0;
+    }
+}
+
+void NtsExecutor::unschedule(NtsTask *task)
+{
+    for (auto &worker : workers)
+    {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        auto &queue = worker->runQueue;
+        for (auto it = queue.begin(); it != queue.end();)
+        {
+            if (*it == task)
+            {
+                it = queue.erase(it);
+                task->inFlight--;
+            }
+            else
+                ++it;
+        }
+    }
+}
+
+NtsTask *NtsExecutor::nextTask(int workerIndex)
+{
+    // Own run queue first
+    {
+        auto &worker = workers[workerIndex];
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        if (!worker->runQueue.empty())
+        {
+            NtsTask *task = worker->runQueue.front();
+            worker->runQueue.pop_front();
+            return task;
+        }
+    }
+
+    // Then try stealing from the other workers
+    size_t count = workers.size();
+    for (size_t i = 1; i < count; i++)
+    {
+        auto &victim = workers[(workerIndex + i) % count];
+        std::unique_lock<std::mutex> lock(victim->mutex);
+        if (!victim->runQueue.empty())
+        {
+            NtsTask *task = victim->runQueue.back();
+            victim->runQueue.pop_back();
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void NtsExecutor::workerLoop(int workerIndex)
+{
+    g_workerIndex = workerIndex;
+
+    while (!isQuiting)
+    {
+        NtsTask *task = nextTask(workerIndex);
+        if (task == nullptr)
+        {
+            std::unique_lock<std::mutex> lock(parkMutex);
+            ++parkedCount;
+            // Check again after announcing parking, so that a concurrent schedule() cannot be missed.
+            task = nextTask(workerIndex);
+            if (task == nullptr && !isQuiting)
+                parkCv.wait_for(lock, std::chrono::milliseconds(EXECUTOR_PARK_TIMEOUT));
+            --parkedCount;
+            if (task == nullptr)
+                continue;
+        }
+
+        // The reference of the run queue is now held by this worker
+        g_currentTask = task;
+
+        if (!task->isQuiting)
+            task->executeOnce();
+
+        g_currentTask = nullptr;
+        task->isScheduled = false;
+
+        if (!task->isQuiting && task->hasPendingWork())
+            schedule(task);
+
+        // No access to the task is allowed after this point, since it may be deleted.
+        task->inFlight--;
+    }
+
+    g_workerIndex = -1;
+}
+
+void NtsExecutor::timerLoop()
+{
+    std::unique_lock<std::mutex> lock(timerMutex);
+
+    while (!isQuiting)
+    {
+        if (wakeups.empty())
+        {
+            timerCv.wait_for(lock, std::chrono::milliseconds(WAIT_TIME_IF_NO_TIMER));
+            continue;
+        }
+
+        int64_t current = utils::MonotonicTimeMillis();
+        auto it = wakeups.begin();
+        if (it->first > current)
+        {
+            int64_t delta = std::min(it->first - current, (int64_t)WAIT_TIME_IF_NO_TIMER);
+            timerCv.wait_for(lock, std::chrono::milliseconds(delta));
+            continue;
+        }
+
+        // Timers of the task are checked with strict comparison, hence wake up slightly after the expiry.
+        if (it->first == current)
+        {
+            timerCv.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+
+        NtsTask *task = it->second;
+        wakeups.erase(it);
+        task->wakeupTime = 0;
+        schedule(task);
+    }
+}
@@ -12,10 +12,12 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <condition_variable>
 #include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -55,19 +57,108 @@ enum class NtsMessageType
     UE_RLS_TO_RRC,
     UE_RLS_TO_APP,
     UE_NAS_TO_APP,
+    UE_WAKE_UP,
+};
+
+struct NtsAllocatorStats
+{
+    struct SizeClass
+    {
+        size_t blockSize{};
+        uint64_t reservedBlocks{}; // Blocks obtained from the heap so far
+        uint64_t depotBlocks{};    // Blocks waiting in the shared depot
+        uint64_t allocations{};    // Published by the threads when they exchange a batch, hence approximate
+    };
+
+    std::vector<SizeClass> sizeClasses{};
+    uint64_t heapAllocations{}; // Messages larger than the largest size class
+    uint64_t batchTransfers{};  // Batches moved between the thread caches and the depot
 };
 
 struct NtsMessage
 {
     const NtsMessageType msgType;
 
+    // Intrusive link of the task mailbox, must not be used by the message owners.
+    std::atomic<NtsMessage *> mailboxNext{};
+
     explicit NtsMessage(NtsMessageType msgType) : msgType(msgType)
     {
     }
 
     virtual ~NtsMessage() = default;
+
+    // - Messages are allocated from per-thread caches of fixed size classes instead of the global heap.
+    // - A message may be released by another thread, such blocks are returned to the allocating threads in batches
+    // through a shared depot.
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr, std::size_t size);
+
+    static NtsAllocatorStats AllocatorStats();
 };
 
+// Fixed number of equally sized memory slots which can be allocated and released from any thread without locking.
+// - Slots are handed out from a lock-free free list, the heap is used if the pool is exhausted.
+// - Pages of the pool are committed lazily by the OS as the slots are used for the first time.
+class NtsSlotPool
+{
+  private:
+    const size_t slotSize;
+    const uint32_t slotCount;
+    uint8_t *storage;
+    std::unique_ptr<std::atomic<uint32_t>[]> nextFree;
+    std::atomic<uint64_t> freeHead{}; // (ABA tag << 32) | (slot index + 1), zero if empty
+    std::atomic<uint32_t> bumpIndex{};
+
+  public:
+    NtsSlotPool(size_t slotSize, uint32_t slotCount);
+
+    NtsSlotPool(const NtsSlotPool &) = delete;
+    NtsSlotPool &operator=(const NtsSlotPool &) = delete;
+
+    void *allocate(size_t size);
+    void deallocate(void *ptr, size_t size);
+};
+
+// Base of the high rate (user plane) messages.
+// - Objects are placed in a pre-allocated slot pool of the type instead of the heap.
+// - The concrete type can be recovered with NtsCast<T>() instead of dynamic_cast.
+template <typename T, NtsMessageType Type, uint32_t PoolSize = 4096>
+struct NtsPooledMessage : NtsMessage
+{
+    static constexpr NtsMessageType TYPE = Type;
+
+    NtsPooledMessage() : NtsMessage(Type)
+    {
+    }
+
+    static void *operator new(std::size_t size)
+    {
+        return Pool()->allocate(size);
+    }
+
+    static void operator delete(void *ptr, std::size_t size)
+    {
+        Pool()->deallocate(ptr, size);
+    }
+
+  private:
+    static NtsSlotPool *Pool()
+    {
+        // Never destroyed, since messages may still be released by other threads during exit.
+        static auto *pool = new NtsSlotPool(sizeof(T), PoolSize);
+        return pool;
+    }
+};
+
+// Converts the message to its concrete type without RTTI. Only applicable to the types declaring their message type
+// as TYPE, e.g. the ones derived from NtsPooledMessage.
+template <typename T>
+inline T *NtsCast(NtsMessage *msg)
+{
+    return msg->msgType == T::TYPE ? static_cast<T *>(msg) : nullptr;
+}
+
 struct NwTimerExpired : NtsMessage
 {
     int timerId;
@@ -77,63 +168,204 @@ struct NwTimerExpired : NtsMessage
     }
 };
 
+// Identifies an armed timer. Zero is never a valid handle.
+using NtsTimerHandle = uint64_t;
+
 struct TimerInfo
 {
     int timerId{};
     int64_t start{};
     int64_t end{};
+    int64_t period{}; // Zero if the timer is not periodic
+
+    // Intrusive timing wheel bookkeeping
+    TimerInfo *prev{};
+    TimerInfo *next{};
+    TimerInfo **list{};
+    uint32_t index{};
+    uint32_t generation{};
 };
 
+// Hierarchical timing wheel with 1ms ticks.
+// - Arming and cancelling a timer are O(1), timer records are recycled.
+// - Times are in milliseconds of utils::MonotonicTimeMillis().
+// - A timer expires when the current time is strictly greater than its end time.
+// - A periodic timer is re-armed in place when it expires, hence its handle remains valid until it is cancelled.
 class TimerBase
 {
-    struct TimerInfoComparator
-    {
-        bool operator()(TimerInfo *a, TimerInfo *b)
-        {
-            return a->end >= b->end;
-        }
-    };
+  public:
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int LEVEL_SIZE = 1 << LEVEL_BITS;
+    static constexpr int LEVEL_COUNT = 4;
+
+  private:
+    TimerInfo *wheel[LEVEL_COUNT][LEVEL_SIZE]{};
+    uint64_t occupied[LEVEL_COUNT]{};
+    TimerInfo *expired{};
+    TimerInfo *expiredTail{};
+    int64_t current{};
+    size_t count{};
 
-    std::priority_queue<TimerInfo *, std::vector<TimerInfo *>, TimerInfoComparator> timerQueue{};
+    std::deque<TimerInfo> records{};
+    std::vector<TimerInfo *> freeRecords{};
 
   public:
-    ~TimerBase();
+    explicit TimerBase(int64_t now = 0);
+
+    NtsTimerHandle setTimerAbsolute(int timerId, int64_t timeMs, int64_t now, int64_t period = 0);
+
+    bool reschedule(NtsTimerHandle handle, int64_t timeMs, int64_t now);
 
-    void setTimerAbsolute(int timerId, int64_t timeMs);
+    bool cancel(NtsTimerHandle handle);
 
-    TimerInfo *getAndRemoveExpiredTimer();
+    // Advances the wheel up to the given time, and removes (or re-arms if periodic) the earliest expired timer if any.
+    bool getAndRemoveExpiredTimer(int64_t now, int &timerId);
 
-    int64_t getNextWaitTime();
+    // Returns the earliest time at which a timer may expire (it can be earlier than the actual expiry), or 0 if there
+    // is no timer.
+    [[nodiscard]] int64_t getNextExpiryTime() const;
+
+    [[nodiscard]] bool isEmpty() const;
+
+    // Estimated heap memory held by the timer records
+    [[nodiscard]] size_t heapUsage() const;
+
+  private:
+    TimerInfo *find(NtsTimerHandle handle);
+    void insert(TimerInfo *timer);
+    void unlink(TimerInfo *timer);
+    void release(TimerInfo *timer);
+    [[nodiscard]] int64_t nextEventTick() const;
+    void cascade();
+    void advance(int64_t now);
 };
 
-// TODO: Limit queue size?
-// todo: message priority, especially control plane messages should have more priorty in appTask etc
+// Lock-free multi-producer single-consumer queue of messages, linked through NtsMessage::mailboxNext.
+// - push() can be called from any thread, pop() only from the single consumer.
+// - pop() may transiently return nullptr while a concurrent push() is not completed yet, isEmpty() returns false in
+// that case.
+class NtsMailbox
+{
+  private:
+    std::atomic<NtsMessage *> head;
+    NtsMessage *tail;
+    NtsMessage stub{NtsMessageType::UNDEFINED};
+
+  public:
+    NtsMailbox();
+
+    NtsMailbox(const NtsMailbox &) = delete;
+    NtsMailbox &operator=(const NtsMailbox &) = delete;
+
+    void push(NtsMessage *msg);
+
+    NtsMessage *pop();
+
+    // Safe to call from any thread
+    [[nodiscard]] bool isEmpty() const;
+};
+
+// Priority lanes of the task mailbox.
+// - Messages in the control lane are always taken before the ones in the bulk lane.
+// - User plane traffic should be pushed to the bulk lane so that it cannot delay the signalling.
+enum class NtsLane
+{
+    CONTROL,
+    BULK,
+};
+
+// Behaviour of a bounded task mailbox when a message is pushed while it is full.
+enum class NtsOverflowPolicy
+{
+    // The producer waits until there is space. Pushes from the tasks and the executor workers are never blocked, the
+    // ones from the threads marked with NtsTask::MarkNonBlockingThread() are dropped instead.
+    BLOCK,
+    // The pushed message is dropped.
+    DROP_NEWEST,
+    // The message is queued, and the oldest messages are dropped (bulk lane first) when the consumer polls.
+    DROP_OLDEST,
+    // Bulk lane messages are dropped, control lane messages are always queued.
+    DROP_BULK,
+};
+
+struct NtsQueueStats
+{
+    size_t capacity{};
+    NtsOverflowPolicy policy{};
+    size_t size{};
+    size_t bulkSize{};
+    uint64_t dropped{};
+    uint64_t blocked{};
+};
+
+class NtsExecutor;
+
 class NtsTask
 {
   private:
-    std::deque<NtsMessage *> msgQueue{};
+    NtsMailbox mailbox{};
+    NtsMailbox bulkMailbox{};
+    std::deque<NtsMessage *> frontQueue{};
+    std::atomic_bool hasFrontMessage{};
     TimerBase timerBase{};
-    std::mutex mutex{};
-    std::condition_variable cv{};
+    std::atomic<int64_t> nextTimerExpiry{};
+    std::mutex mutex{}; // Guards frontQueue and timerBase
+    std::atomic_int parkState{};
+
+    // Bounded mailbox configuration and accounting, capacity is zero if unbounded
+    size_t capacity{};
+    NtsOverflowPolicy overflowPolicy{};
+    std::atomic_size_t queuedCount{};
+    std::atomic_size_t bulkQueuedCount{};
+    std::atomic_uint64_t droppedCount{};
+    std::atomic_uint64_t blockedCount{};
+    std::atomic_int spaceState{};
     std::atomic_bool isQuiting{};
     std::atomic_int pauseReqCount{};
     std::atomic_bool pauseConfirmed{};
     std::thread thread;
 
+    // Used only if the task is scheduled on an executor instead of its own thread
+    std::atomic<NtsExecutor *> executor{};
+    std::atomic_bool isScheduled{};
+    std::atomic_int inFlight{}; // References held by the run queues and the workers
+    // Time of the only pending wakeup of the task in the executor, zero if none. Written under the timer mutex.
+    std::atomic<int64_t> wakeupTime{};
+
+    friend class NtsExecutor;
+
   public:
     NtsTask() = default;
 
     virtual ~NtsTask() = default;
 
     // NtsTask takes the ownership of NtsMessage* after somebody pushes the message.
-    bool push(NtsMessage *msg);
+    bool push(NtsMessage *msg, NtsLane lane = NtsLane::CONTROL);
 
     // NtsTask takes the ownership of NtsMessage* after somebody pushes the message.
     bool pushFront(NtsMessage *msg);
 
-    bool setTimer(int timerId, int64_t delayMs);
+    // - Marks the calling thread as one that must never wait for a consumer, e.g. a thread delivering to many tasks.
+    // - Its pushes to a full mailbox with the block policy are dropped and counted instead.
+    static void MarkNonBlockingThread();
+
+    // - Arms a timer which is delivered as NwTimerExpired message after the delay.
+    // - Returns a handle which can be used to cancel or reschedule the timer, or 0 if the task is quiting.
+    NtsTimerHandle setTimer(int timerId, int64_t delayMs);
+
+    // - Same as setTimer() but the time is in terms of utils::MonotonicTimeMillis().
+    NtsTimerHandle setTimerAbsolute(int timerId, int64_t timeMs);
+
+    // - Arms a timer which is delivered every period, starting one period later. Missed periods are skipped.
+    // - The timer is re-armed without a new handle, it is only stopped by cancelTimer().
+    NtsTimerHandle setPeriodicTimer(int timerId, int64_t periodMs);
+
+    // - Returns false if the timer is already expired or cancelled.
+    bool cancelTimer(NtsTimerHandle handle);
 
-    bool setTimerAbsolute(int timerId, int64_t timeMs);
+    // - Re-arms a pending timer with the new delay, a periodic timer keeps its period afterwards. Returns false if the
+    //   timer is already expired or cancelled.
+    bool rescheduleTimer(NtsTimerHandle handle, int64_t delayMs);
 
   protected:
     // NtsTask gives the ownership of NtsMessage* to the taker (actually almost always it's its itself)
@@ -145,6 +377,13 @@ class NtsTask
     // NtsTask gives the ownership of NtsMessage* to the taker (actually almost always it's its itself)
     NtsMessage *take();
 
+    // - Clears the batch and fills it with at most 'max' messages, waiting for the first one as take() does.
+    // - Returns the number of taken messages, NtsTask gives the ownership of them to the taker.
+    size_t takeBatch(std::vector<NtsMessage *> &batch, size_t max);
+
+    // - Same as takeBatch(batch, max) but waits for the first message at most 'timeout' milliseconds.
+    size_t takeBatch(std::vector<NtsMessage *> &batch, size_t max, int64_t timeout);
+
   protected:
     // Called exactly once after start() called and before onLoop() callbacks.
     virtual void onStart() = 0;
@@ -159,7 +398,9 @@ class NtsTask
     // - NTS task starts with this function.
     // - Calling start() multiple times is undefined behaviour.
     // - This function is executed by the caller as blocking.
-    void start();
+    // - If an executor is given, the task does not own a thread. Instead onLoop() is invoked by the executor's workers
+    // whenever there is a message or an expired timer, and take()/poll() never block in that case.
+    void start(NtsExecutor *executor = nullptr);
 
     // - NTS task begins to be stopped after called this function. The task may stop after some delay. (usually
     // WAIT_TIME_IF_NO_TIMER).
@@ -180,4 +421,74 @@ class NtsTask
 
     // - Returns true iff pause was requested and now is confirmed.
     bool isPauseConfirmed();
+
+    // - Limits the number of queued messages (excluding timers) with the given policy. Zero means unbounded.
+    // - Should be called before start().
+    void setQueueCapacity(size_t capacity, NtsOverflowPolicy policy);
+
+    // - Can be called from any thread.
+    [[nodiscard]] NtsQueueStats getQueueStats() const;
+
+    // - Estimated heap memory held by the task itself, excluding the queued messages. Can be called from any thread.
+    size_t heapUsage();
+
+  private:
+    bool admit(NtsLane lane);
+    NtsMessage *dequeue(NtsMailbox &box);
+    void onDequeued(bool isBulk);
+    void dropOldest();
+    NtsMessage *pollTimer();
+    NtsTimerHandle armTimer(int timerId, int64_t timeMs, int64_t period);
+    void park(int64_t timeout);
+    void wake();
+    bool hasPendingWork();
+    void executeOnce();
+};
+
+// Schedules NtsTasks as lightweight actors on a fixed pool of worker threads instead of one thread per task.
+// - Each worker has its own run queue, idle workers steal tasks from the others.
+// - A task is processed by at most one worker at a time.
+// - Expired timers of the tasks are tracked by an additional timer thread.
+class NtsExecutor
+{
+  private:
+    struct Worker
+    {
+        std::mutex mutex{};
+        std::deque<NtsTask *> runQueue{};
+        std::thread thread{};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers{};
+    std::atomic_bool isQuiting{};
+    std::atomic_int parkedCount{};
+    std::atomic_size_t nextWorker{};
+    std::mutex parkMutex{};
+    std::condition_variable parkCv{};
+
+    std::set<std::pair<int64_t, NtsTask *>> wakeups{}; // At most one per task, see NtsTask::wakeupTime
+    std::mutex timerMutex{};
+    std::condition_variable timerCv{};
+    std::thread timerThread{};
+
+  public:
+    explicit NtsExecutor(int threadCount);
+    ~NtsExecutor();
+
+    NtsExecutor(const NtsExecutor &) = delete;
+    NtsExecutor &operator=(const NtsExecutor &) = delete;
+
+    [[nodiscard]] int threadCount() const;
+
+  private:
+    friend class NtsTask;
+
+    void schedule(NtsTask *task);
+    void scheduleAt(NtsTask *task, int64_t timeMs);
+    void cancel(NtsTask *task);
+    void unschedule(NtsTask *task);
+
+    NtsTask *nextTask(int workerIndex);
+    void workerLoop(int workerIndex);
+    void timerLoop();
 };
\ No newline at end of file
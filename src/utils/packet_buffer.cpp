@@ -0,0 +1,181 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "packet_buffer.hpp"
+#include "nts.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// Covers an MTU sized packet with the headers of the user plane protocols
+#define POOLED_BLOCK_SIZE 2048
+// Pages of the pool are committed as the slots are used for the first time
+#define POOLED_BLOCK_COUNT 8192
+
+static NtsSlotPool *BlockPool()
+{
+    // Never destroyed, since the buffers may still be released by other threads during exit
+    static auto *pool = new NtsSlotPool(POOLED_BLOCK_SIZE, POOLED_BLOCK_COUNT);
+    return pool;
+}
+
+PacketBuffer::PacketBuffer() noexcept : m_block{}, m_offset{}, m_length{}
+{
+}
+
+PacketBuffer::PacketBuffer(const PacketBuffer &other) noexcept
+    : m_block{other.m_block}, m_offset{other.m_offset}, m_length{other.m_length}
+{
+    if (m_block != nullptr)
+        m_block->refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+PacketBuffer::PacketBuffer(PacketBuffer &&other) noexcept
+    : m_block{other.m_block}, m_offset{other.m_offset}, m_length{other.m_length}
+{
+    other.m_block = nullptr;
+    other.m_offset = 0;
+    other.m_length = 0;
+}
+
+PacketBuffer::~PacketBuffer()
+{
+    release();
+}
+
+PacketBuffer &PacketBuffer::operator=(const PacketBuffer &other) noexcept
+{
+    if (this != &other)
+    {
+        if (other.m_block != nullptr)
+            other.m_block->refCount.fetch_add(1, std::memory_order_relaxed);
+        release();
+        m_block = other.m_block;
+        m_offset = other.m_offset;
+        m_length = other.m_length;
+    }
+    return *this;
+}
+
+PacketBuffer &PacketBuffer::operator=(PacketBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_block = other.m_block;
+        m_offset = other.m_offset;
+        m_length = other.m_length;
+        other.m_block = nullptr;
+        other.m_offset = 0;
+        other.m_length = 0;
+    }
+    return *this;
+}
+
+void PacketBuffer::release()
+{
+    if (m_block == nullptr)
+        return;
+
+    if (m_block->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        size_t size = sizeof(Block) + m_block->capacity;
+        m_block->~Block();
+        BlockPool()->deallocate(m_block, size);
+    }
+
+    m_block = nullptr;
+    m_offset = 0;
+    m_length = 0;
+}
+
+PacketBuffer PacketBuffer::Allocate(size_t headroom, size_t size)
+{
+    // The pooled size is used whenever it is enough, so that the block is taken from the pool
+    size_t blockSize = std::max<size_t>(sizeof(Block) + headroom + size, POOLED_BLOCK_SIZE);
+
+    auto *block = new (BlockPool()->allocate(blockSize)) Block{};
+    block->refCount.store(1, std::memory_order_relaxed);
+    block->capacity = static_cast<uint32_t>(blockSize - sizeof(Block));
+
+    PacketBuffer res{};
+    res.m_block = block;
+    res.m_offset = static_cast<uint32_t>(headroom);
+    res.m_length = static_cast<uint32_t>(size);
+    return res;
+}
+
+PacketBuffer PacketBuffer::FromOctetString(const OctetString &data, size_t headroom, size_t tailroom)
+{
+    auto length = static_cast<size_t>(data.length());
+    PacketBuffer res = Allocate(headroom, length + tailroom);
+    res.resize(length);
+    if (length > 0)
+        std::memcpy(res.data(), data.data(), length);
+    return res;
+}
+
+bool PacketBuffer::isNull() const
+{
+    return m_block == nullptr;
+}
+
+const uint8_t *PacketBuffer::data() const
+{
+    return m_block == nullptr ? nullptr : reinterpret_cast<const uint8_t *>(m_block + 1) + m_offset;
+}
+
+uint8_t *PacketBuffer::data()
+{
+    return m_block == nullptr ? nullptr : reinterpret_cast<uint8_t *>(m_block + 1) + m_offset;
+}
+
+size_t PacketBuffer::length() const
+{
+    return m_length;
+}
+
+size_t PacketBuffer::headroom() const
+{
+    return m_offset;
+}
+
+size_t PacketBuffer::tailroom() const
+{
+    return m_block == nullptr ? 0 : m_block->capacity - m_offset - m_length;
+}
+
+void PacketBuffer::resize(size_t length)
+{
+    m_length = static_cast<uint32_t>(length);
+}
+
+uint8_t *PacketBuffer::prepend(size_t size)
+{
+    m_offset -= static_cast<uint32_t>(size);
+    m_length += static_cast<uint32_t>(size);
+    return data();
+}
+
+uint8_t *PacketBuffer::append(size_t size)
+{
+    uint8_t *res = data() + m_length;
+    m_length += static_cast<uint32_t>(size);
+    return res;
+}
+
+OctetString PacketBuffer::toOctetString() const
+{
+    return OctetString::FromArray(data(), m_length);
+}
+
+size_t PacketBuffer::memoryUsage() const
+{
+    return m_block == nullptr ? 0 : sizeof(Block) + m_block->capacity;
+}
@@ -0,0 +1,72 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "octet_string.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Reference counted packet buffer with a headroom and a tailroom, so that the headers and the trailers of the lower
+// layers are added in place instead of copying the packet.
+// - The blocks of the usual packet sizes are taken from a lock-free slot pool, and can be released from any thread.
+// - Copies of a handle share the same block, which is released with the last handle. The data must not be modified
+//   while the block is shared.
+class PacketBuffer
+{
+  private:
+    struct Block
+    {
+        std::atomic<uint32_t> refCount;
+        uint32_t capacity; // Number of the bytes following the block header
+    };
+
+    Block *m_block;
+    uint32_t m_offset; // Start of the data from the end of the block header
+    uint32_t m_length;
+
+  public:
+    PacketBuffer() noexcept;
+    PacketBuffer(const PacketBuffer &other) noexcept;
+    PacketBuffer(PacketBuffer &&other) noexcept;
+    ~PacketBuffer();
+
+    PacketBuffer &operator=(const PacketBuffer &other) noexcept;
+    PacketBuffer &operator=(PacketBuffer &&other) noexcept;
+
+  public:
+    // Allocates a block having the given headroom followed by at least the given size, the length of the data is the
+    // given size.
+    static PacketBuffer Allocate(size_t headroom, size_t size);
+    // Copies the octet string into a new block with the given headroom and tailroom
+    static PacketBuffer FromOctetString(const OctetString &data, size_t headroom, size_t tailroom);
+
+  public:
+    [[nodiscard]] bool isNull() const;
+    [[nodiscard]] const uint8_t *data() const;
+    uint8_t *data();
+    [[nodiscard]] size_t length() const;
+    [[nodiscard]] size_t headroom() const;
+    [[nodiscard]] size_t tailroom() const;
+
+    // Sets the length of the data, e.g. after reading into the buffer. Must not exceed the length and the tailroom.
+    void resize(size_t length);
+    // Extends the data into the headroom and returns the new start of the data. Must not exceed the headroom.
+    uint8_t *prepend(size_t size);
+    // Extends the data into the tailroom and returns the start of the extension. Must not exceed the tailroom.
+    uint8_t *append(size_t size);
+
+    [[nodiscard]] OctetString toOctetString() const;
+    // Memory held by the block
+    [[nodiscard]] size_t memoryUsage() const;
+
+  private:
+    void release();
+};